@@ -33,6 +33,11 @@ class RRTstarPreparatory
 		void initGridMap(double _resolution, Eigen::Vector3d global_xyz_l, Eigen::Vector3d global_xyz_u, int max_x_id, int max_y_id, int max_z_id);
 		void setObs(const double coord_x, const double coord_y, const double coord_z);
 		bool isObsFree(const double coord_x, const double coord_y, const double coord_z);
+
+		// batched isObsFree over [num] points in structure-of-arrays layout, is_free[i] is set to 1 for free points
+		void isObsFree(const double * coord_x, const double * coord_y, const double * coord_z, const int num, uint8_t * is_free);
+		// first occupied point among from + (step / num_steps) * (to - from), step in [first_step, num_steps], -1 if all are free
+		int findFirstOccupied(const Eigen::Vector3d & from, const Eigen::Vector3d & to, const int num_steps, const int first_step = 0);
 		
 		Eigen::Vector3d coordRounding(const Eigen::Vector3d & coord);
 };
@@ -0,0 +1,119 @@
+#ifndef _LAZY_PRM_STAR_H_
+#define _LAZY_PRM_STAR_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <Eigen/Eigen>
+#include "graph_searcher.h"
+
+// multi-query roadmap over the RRTstarPreparatory grid.
+//
+// the roadmap is built once without any collision checking, written to a flat binary file and
+// memory-mapped on startup, so a restarted node only pays for mmap(). vertex / edge validity is
+// resolved lazily during queries and cached in a private copy-on-write view of the mapping.
+//
+// file layout, all offsets 8-byte aligned:
+//
+//     RoadmapHeader
+//     double   vertices[3 * num_vertices]
+//     uint32_t offsets[num_vertices + 1]      CSR row pointers into adjacency
+//     uint32_t adjacency[num_edges]           directed, every undirected edge appears twice
+//     uint8_t  vertex_state[num_vertices]     ValidityState, Unknown on disk
+//     uint8_t  edge_state[num_edges]          ValidityState, Unknown on disk
+class LazyPRMstar
+{
+	private:
+		struct RoadmapHeader
+		{
+			char     magic[8];
+			uint32_t version;
+			uint32_t num_vertices;
+			uint64_t num_edges;
+			uint64_t file_size;
+			double   lower[3];
+			double   upper[3];
+			double   resolution;
+		};
+
+		enum ValidityState : uint8_t {
+			Unknown = 0,
+			Valid   = 1,
+			Invalid = 2
+		};
+
+		static constexpr char     Magic[8] = {'L', 'Z', 'P', 'R', 'M', 'S', 'T', 'R'};
+		static constexpr uint32_t Version  = 1;
+
+		RRTstarPreparatory * grid;
+
+		Eigen::Vector3d lower, upper;
+		double resolution;
+
+		// memory-mapped roadmap:
+		void   * mapped;
+		size_t   mapped_size;
+
+		uint32_t num_vertices;
+		uint64_t num_edges;
+
+		const double   * vertices;
+		const uint32_t * offsets;
+		const uint32_t * adjacency;
+		uint8_t        * vertex_state;
+		uint8_t        * edge_state;
+
+		// per-query scratch, sized once on load:
+		std::vector<double>   g_score;
+		std::vector<int>      came_from;
+		std::vector<uint8_t>  closed;
+		std::vector<uint8_t>  goal_linked;
+		std::vector<uint32_t> start_links, goal_links;
+
+		static size_t alignUp(const size_t offset) { return (offset + 7) & ~size_t(7); }
+		static void computeLayout(
+			const uint32_t n_vertices, const uint64_t n_edges,
+			size_t & vertices_offset, size_t & offsets_offset, size_t & adjacency_offset,
+			size_t & vertex_state_offset, size_t & edge_state_offset, size_t & file_size
+		);
+
+		inline Eigen::Vector3d vertex(const uint32_t v) const {
+			return Eigen::Vector3d(vertices[3 * v + 0], vertices[3 * v + 1], vertices[3 * v + 2]);
+		}
+
+		bool isVertexValid(const uint32_t v);
+		bool isEdgeValid(const uint32_t u, const uint64_t e);
+		void validateIncidentEdges(const uint32_t u);
+		void setEdgeState(const uint32_t u, const uint32_t v, const ValidityState state);
+		bool isSegmentFree(const Eigen::Vector3d & from, const Eigen::Vector3d & to);
+
+		void findNearest(const Eigen::Vector3d & pt, const size_t k, std::vector<uint32_t> & nearest) const;
+		void linkToRoadmap(const Eigen::Vector3d & pt, std::vector<uint32_t> & links);
+		bool searchGraph(const Eigen::Vector3d & start_pt, const Eigen::Vector3d & target_pt, std::vector<int> & vertex_path);
+
+		void unmap();
+
+	public:
+		LazyPRMstar(RRTstarPreparatory * _grid, double _resolution, Eigen::Vector3d global_xyz_l, Eigen::Vector3d global_xyz_u);
+		~LazyPRMstar();
+
+		// sample [num_samples] vertices uniformly over the map, connect each to its k-PRM* nearest
+		// neighbours and serialise the result to [roadmap_file]. no collision checking is done here.
+		bool build(const std::string & roadmap_file, const int num_samples, const unsigned int seed = 0);
+
+		// memory-map a roadmap previously written by build(). fails if the file does not match the map
+		bool load(const std::string & roadmap_file);
+
+		// forget all cached validity results, e.g. after the obstacle map has changed
+		void resetValidation();
+
+		bool isLoaded() const { return mapped != nullptr; }
+		uint32_t getNumVertices() const { return num_vertices; }
+
+		// graph search plus lazy edge validation. returns false if start and target cannot be connected
+		bool query(const Eigen::Vector3d & start_pt, const Eigen::Vector3d & target_pt, std::vector<Eigen::Vector3d> & path);
+};
+
+#endif
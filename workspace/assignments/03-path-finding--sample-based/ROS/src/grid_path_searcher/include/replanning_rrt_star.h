@@ -0,0 +1,94 @@
+#ifndef _REPLANNING_RRT_STAR_H_
+#define _REPLANNING_RRT_STAR_H_
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <Eigen/Eigen>
+#include "graph_searcher.h"
+
+// RRT* over the RRTstarPreparatory grid which keeps its tree between queries towards the same target.
+//
+// when the start moves, the tree is re-rooted: the node nearest to the new start that can see it
+// becomes the only child of the new root and the parent links of the rest of its component are
+// re-oriented away from it. tree edges hit by new obstacles are pruned first, the components which
+// lose their connection to the re-rooted tree are dropped, everything else is kept and refined.
+class ReplanningRRTstar
+{
+	private:
+		struct TreeNode
+		{
+			double cost;                  // cost-to-come from the root
+			int parent;
+			std::vector<int> children;
+
+			TreeNode() : cost(0.0), parent(-1) {}
+		};
+
+		RRTstarPreparatory * grid;
+
+		Eigen::Vector3d lower, upper;
+		double resolution;
+
+		double max_step;
+		double gamma;
+		double goal_bias;
+		int    max_nodes;
+
+		// positions are kept apart from the topology, nearest neighbour queries scan them linearly
+		std::vector<Eigen::Vector3d> positions;
+		std::vector<TreeNode> nodes;
+
+		Eigen::Vector3d target;
+		int  goal_id;
+		bool map_changed;
+
+		std::mt19937 generator;
+
+		// scratch for near neighbour queries and re-rooting
+		std::vector<std::pair<double, int>> candidates;
+		std::vector<int> near_ids;
+
+		double getSearchRadius() const;
+		bool   isSegmentFree(const Eigen::Vector3d & from, const Eigen::Vector3d & to);
+
+		int    findNearest(const Eigen::Vector3d & pt) const;
+		void   findNear(const Eigen::Vector3d & pt, const double radius, std::vector<int> & ids) const;
+
+		int    addNode(const Eigen::Vector3d & pt, const int parent, const double cost);
+		void   reparent(const int node_id, const int parent_id, const double cost);
+		void   removeLeaf(const int node_id);
+		bool   recycleLeaf(const int keep_id);
+
+		void   pruneInvalidEdges(std::vector<uint8_t> & edge_valid);
+		bool   reroot(const Eigen::Vector3d & start_pt);
+
+		void   extend();
+
+	public:
+		ReplanningRRTstar(RRTstarPreparatory * _grid, double _resolution, Eigen::Vector3d global_xyz_l, Eigen::Vector3d global_xyz_u);
+		~ReplanningRRTstar(){};
+
+		// [_max_step] is the steering distance, [_gamma] scales the RRT* rewiring radius, [_goal_bias] is
+		// the probability of sampling the target. the tree stops growing at [_max_nodes], which bounds the
+		// cost of the linear neighbour queries when it is kept over many replanning cycles. a full tree keeps
+		// being refined: every node added to it recycles a random leaf off the path to the target
+		void setParam(double _max_step, double _gamma, double _goal_bias, int _max_nodes);
+
+		// the obstacle map has changed, prune the tree before the next query
+		void setMapChanged() { map_changed = true; }
+
+		// drop the whole tree
+		void reset();
+
+		// plan towards [target_pt] for [time_budget] seconds. the tree of the previous query is reused
+		// if it was grown towards the same target, otherwise planning starts from scratch
+		bool plan(const Eigen::Vector3d & start_pt, const Eigen::Vector3d & target_pt, const double time_budget, std::vector<Eigen::Vector3d> & path);
+
+		int    getTreeSize() const { return nodes.size(); }
+		double getCost() const;
+};
+
+#endif
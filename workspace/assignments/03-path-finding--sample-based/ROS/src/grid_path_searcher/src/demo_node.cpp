@@ -1,12 +1,17 @@
 #include <iostream>
 #include <fstream>
 #include <math.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <pcl_conversions/pcl_conversions.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 #include <ros/ros.h>
 #include <ros/console.h>
 #include <sensor_msgs/PointCloud2.h>
+#include <std_msgs/Empty.h>
+#include <std_msgs/Float64.h>
 
 #include <nav_msgs/Odometry.h>
 #include <nav_msgs/Path.h>
@@ -20,12 +25,16 @@
 #include <ompl/base/spaces/RealVectorBounds.h>
 #include <ompl/base/spaces/RealVectorStateSpace.h>
 #include <ompl/base/StateValidityChecker.h>
+#include <ompl/base/MotionValidator.h>
 #include <ompl/base/OptimizationObjective.h>
+#include <ompl/base/PlannerTerminationCondition.h>
 #include <ompl/base/objectives/PathLengthOptimizationObjective.h>
 #include <ompl/geometric/planners/rrt/RRTstar.h>
 #include <ompl/geometric/SimpleSetup.h>
 
 #include "graph_searcher.h"
+#include "lazy_prm_star.h"
+#include "replanning_rrt_star.h"
 #include "backward.hpp"
 
 using namespace std;
@@ -42,6 +51,20 @@ backward::SignalHandling sh;
 double _resolution, _inv_resolution, _cloud_margin;
 double _x_size, _y_size, _z_size;    
 
+// multi-query roadmap
+std::string _planning_method, _roadmap_file;
+int _roadmap_samples;
+
+// anytime planning
+bool   _anytime_planning;
+double _planning_time_budget;
+
+// replanning with a persistent tree
+double _replan_rate, _replan_time_budget, _replan_max_step;
+int    _replan_max_nodes;
+bool   _has_target = false;
+Vector3d _target_pt;
+
 // useful global variables
 bool _has_map   = false;
 
@@ -50,14 +73,33 @@ Vector3d _map_lower, _map_upper;
 int _max_x_id, _max_y_id, _max_z_id;
 
 // ros related
-ros::Subscriber _map_sub, _pts_sub;
+ros::Subscriber _map_sub, _pts_sub, _odom_sub, _cancel_sub, _extend_sub;
 ros::Publisher  _grid_map_vis_pub, _RRTstar_path_vis_pub;
+ros::Timer      _replan_timer;
 
 RRTstarPreparatory * _RRTstar_preparatory = new RRTstarPreparatory();
+LazyPRMstar        * _lazy_prm_star       = NULL;
+ReplanningRRTstar  * _replanning_rrt_star = NULL;
+
+// background planner of the anytime mode. the deadline is kept as steady clock ticks
+// so that it can be moved while the planner is running
+std::thread                _planner_thread;
+std::atomic<bool>          _planner_cancel(false);
+std::atomic<bool>          _planner_running(false);
+std::atomic<long long>     _planner_deadline(0);
 
 void rcvWaypointsCallback(const nav_msgs::Path & wp);
 void rcvPointCloudCallBack(const sensor_msgs::PointCloud2 & pointcloud_map);
-void pathFinding(const Vector3d start_pt, const Vector3d target_pt);
+void rcvOdometryCallback(const nav_msgs::Odometry & odom);
+void rcvCancelCallback(const std_msgs::Empty & msg);
+void rcvExtendCallback(const std_msgs::Float64 & msg);
+void replanCallback(const ros::TimerEvent & event);
+void pathFinding(const Vector3d start_pt, const Vector3d target_pt, const ob::PlannerTerminationCondition & ptc, const bool stream_solutions);
+void anytimePathFinding(const Vector3d start_pt, const Vector3d target_pt);
+void cancelPathFinding();
+void extendPathFinding(const double seconds);
+void roadmapPathFinding(const Vector3d start_pt, const Vector3d target_pt);
+void prepareRoadmap();
 void visRRTstarPath(vector<Vector3d> nodes );
 
 void rcvWaypointsCallback(const nav_msgs::Path & wp)
@@ -71,12 +113,23 @@ void rcvWaypointsCallback(const nav_msgs::Path & wp)
                  wp.poses[0].pose.position.z;
 
     ROS_INFO("[node] receive the planning target");
-    pathFinding(_start_pt, target_pt); 
+    _target_pt  = target_pt;
+    _has_target = true;
+
+    if( _replanning_rrt_star != NULL )
+        replanCallback(ros::TimerEvent());
+    else if( _lazy_prm_star != NULL )
+        roadmapPathFinding(_start_pt, target_pt);
+    else if( _anytime_planning )
+        anytimePathFinding(_start_pt, target_pt);
+    else
+        pathFinding(_start_pt, target_pt, ob::timedPlannerTerminationCondition(_planning_time_budget), false); 
 }
 
 void rcvPointCloudCallBack(const sensor_msgs::PointCloud2 & pointcloud_map)
 {   
-    if(_has_map ) return;
+    // only the replanning mode follows map updates, obstacles are added but never cleared
+    if(_has_map && _replanning_rrt_star == NULL) return;
 
     pcl::PointCloud<pcl::PointXYZ> cloud;
     pcl::PointCloud<pcl::PointXYZ> cloud_vis;
@@ -112,6 +165,72 @@ void rcvPointCloudCallBack(const sensor_msgs::PointCloud2 & pointcloud_map)
     _grid_map_vis_pub.publish(map_vis);
 
     _has_map = true;
+
+    if( _replanning_rrt_star != NULL )
+        _replanning_rrt_star->setMapChanged();
+
+    if( _planning_method == "lazy_prm_star" && _lazy_prm_star == NULL )
+        prepareRoadmap();
+}
+
+// map the persisted roadmap, building it first if there is none for this map yet
+void prepareRoadmap()
+{
+    _lazy_prm_star = new LazyPRMstar(_RRTstar_preparatory, _resolution, _map_lower, _map_upper);
+
+    if( _lazy_prm_star->load(_roadmap_file) )
+        return;
+
+    ROS_INFO("[node] no usable roadmap at %s, building one", _roadmap_file.c_str());
+    if( !_lazy_prm_star->build(_roadmap_file, _roadmap_samples) || !_lazy_prm_star->load(_roadmap_file) )
+    {
+        ROS_WARN("[node] roadmap unavailable, fall back to RRT*");
+        delete _lazy_prm_star;
+        _lazy_prm_star = NULL;
+    }
+}
+
+void roadmapPathFinding(const Vector3d start_pt, const Vector3d target_pt)
+{
+    vector<Vector3d> path_points;
+
+    ros::Time time_1 = ros::Time::now();
+    bool solved = _lazy_prm_star->query(start_pt, target_pt, path_points);
+    ros::Time time_2 = ros::Time::now();
+
+    ROS_INFO("[node] roadmap query %s in %f ms", solved ? "succeeded" : "failed", (time_2 - time_1).toSec() * 1000.0);
+
+    if( solved )
+        visRRTstarPath(path_points);
+}
+
+// only the replanning mode follows the odometry, the other planners keep the configured start
+void rcvOdometryCallback(const nav_msgs::Odometry & odom)
+{
+    if( _replanning_rrt_star == NULL )
+        return;
+
+    _start_pt << odom.pose.pose.position.x,
+                 odom.pose.pose.position.y,
+                 odom.pose.pose.position.z;
+}
+
+// re-root the tree at the current start and keep refining towards the same target
+void replanCallback(const ros::TimerEvent & event)
+{
+    if( !_has_map || !_has_target )
+        return;
+
+    vector<Vector3d> path_points;
+
+    ros::Time time_1 = ros::Time::now();
+    bool solved = _replanning_rrt_star->plan(_start_pt, _target_pt, _replan_time_budget, path_points);
+    ros::Time time_2 = ros::Time::now();
+
+    ROS_INFO("[node] replanning %s in %f ms, tree size %d", solved ? "succeeded" : "failed", (time_2 - time_1).toSec() * 1000.0, _replanning_rrt_star->getTreeSize());
+
+    if( solved )
+        visRRTstarPath(path_points);
 }
 
 // Our collision checker. For this demo, our robot's state space
@@ -140,6 +259,60 @@ public:
     }
 };
 
+// Our motion validator. Instead of one virtual isValid() call per interpolated
+// state, the whole edge is handed to the batched checker of the grid map. The
+// discretisation follows ompl::base::DiscreteMotionValidator, s1 is assumed valid.
+class BatchMotionValidator : public ob::MotionValidator
+{
+public:
+    BatchMotionValidator(const ob::SpaceInformationPtr& si) :
+        ob::MotionValidator(si) {}
+
+    bool checkMotion(const ob::State* s1, const ob::State* s2) const
+    {
+        const int num_steps = si_->getStateSpace()->validSegmentCount(s1, s2);
+
+        if (findFirstOccupied(s1, s2, num_steps) < 0) {
+            valid_++;
+            return true;
+        }
+
+        invalid_++;
+        return false;
+    }
+
+    bool checkMotion(const ob::State* s1, const ob::State* s2, std::pair<ob::State*, double>& lastValid) const
+    {
+        const int num_steps = si_->getStateSpace()->validSegmentCount(s1, s2);
+        const int first_occupied = findFirstOccupied(s1, s2, num_steps);
+
+        if (first_occupied < 0) {
+            valid_++;
+            return true;
+        }
+
+        lastValid.second = double(first_occupied - 1) / double(num_steps);
+        if (lastValid.first != nullptr)
+            si_->getStateSpace()->interpolate(s1, s2, lastValid.second, lastValid.first);
+
+        invalid_++;
+        return false;
+    }
+
+private:
+    int findFirstOccupied(const ob::State* s1, const ob::State* s2, const int num_steps) const
+    {
+        const ob::RealVectorStateSpace::StateType* from = s1->as<ob::RealVectorStateSpace::StateType>();
+        const ob::RealVectorStateSpace::StateType* to   = s2->as<ob::RealVectorStateSpace::StateType>();
+
+        return _RRTstar_preparatory->findFirstOccupied(
+            Vector3d(from->values[0], from->values[1], from->values[2]),
+            Vector3d(to->values[0],   to->values[1],   to->values[2]),
+            num_steps, 1
+        );
+    }
+};
+
 // Returns a structure representing the optimization objective to use
 // for optimal motion planning. This method returns an objective which
 // attempts to minimize the length in configuration space of computed
@@ -156,7 +329,25 @@ ob::OptimizationObjectivePtr getThresholdPathLengthObj(const ob::SpaceInformatio
     return obj;
 }
 
-void pathFinding(const Vector3d start_pt, const Vector3d target_pt)
+// convert an intermediate solution reported by RRT* into a displayable path. the reported states
+// run from the parent of the goal motion back to the first child of the root, both ends excluded
+vector<Vector3d> getIntermediatePath(const Vector3d & start_pt, const Vector3d & target_pt, const std::vector<const ob::State*> & states)
+{
+    vector<Vector3d> path_points;
+    path_points.reserve(states.size() + 2);
+
+    path_points.push_back(start_pt);
+    for (auto it = states.rbegin(); it != states.rend(); ++it)
+    {
+        const ob::RealVectorStateSpace::StateType *state = (*it)->as<ob::RealVectorStateSpace::StateType>();
+        path_points.emplace_back(state->values[0], state->values[1], state->values[2]);
+    }
+    path_points.push_back(target_pt);
+
+    return path_points;
+}
+
+void pathFinding(const Vector3d start_pt, const Vector3d target_pt, const ob::PlannerTerminationCondition & ptc, const bool stream_solutions)
 {
     //
     // init the robot state space for path finding: 
@@ -179,6 +370,8 @@ void pathFinding(const Vector3d start_pt, const Vector3d target_pt)
     ob::SpaceInformationPtr si(new ob::SpaceInformation(space));
     // set state validity checker:
     si->setStateValidityChecker(ob::StateValidityCheckerPtr(new ValidityChecker(si)));
+    // check edges in batches:
+    si->setMotionValidator(ob::MotionValidatorPtr(new BatchMotionValidator(si)));
     si->setup();
 
     /*
@@ -214,6 +407,19 @@ void pathFinding(const Vector3d start_pt, const Vector3d target_pt)
     // b. set the optimization objective
     pdef->setOptimizationObjective(getPathLengthObjective(si));
 
+    // publish every improvement of the best cost as soon as it is found:
+    if (stream_solutions)
+    {
+        const ros::Time time_start = ros::Time::now();
+        pdef->setIntermediateSolutionCallback(
+            [start_pt, target_pt, time_start](const ob::Planner*, const std::vector<const ob::State*> & states, const ob::Cost cost)
+            {
+                ROS_INFO("[node] improved solution, cost %f after %f ms", cost.value(), (ros::Time::now() - time_start).toSec() * 1000.0);
+                visRRTstarPath(getIntermediatePath(start_pt, target_pt, states));
+            }
+        );
+    }
+
     /*
         STEP 6: set the optimization planner 
     */ 
@@ -224,9 +430,8 @@ void pathFinding(const Vector3d start_pt, const Vector3d target_pt)
     optimizingPlanner->setProblemDefinition(pdef);
     optimizingPlanner->setup();
 
-    // attempt to solve the planning problem within one second of
-    // planning time
-    ob::PlannerStatus solved = optimizingPlanner->solve(1.0);
+    // attempt to solve the planning problem until the termination condition is met
+    ob::PlannerStatus solved = optimizingPlanner->solve(ptc);
 
     if (solved)
     {
@@ -252,6 +457,81 @@ void pathFinding(const Vector3d start_pt, const Vector3d target_pt)
     }
 }
 
+// run the planner in the background and stream its solutions. a running query is cancelled first
+void anytimePathFinding(const Vector3d start_pt, const Vector3d target_pt)
+{
+    cancelPathFinding();
+
+    _planner_cancel   = false;
+    _planner_deadline = 0;
+    extendPathFinding(_planning_time_budget);
+
+    _planner_running  = true;
+    _planner_thread = std::thread([start_pt, target_pt]()
+    {
+        ob::PlannerTerminationCondition ptc([]()
+        {
+            return _planner_cancel.load() ||
+                   std::chrono::steady_clock::now().time_since_epoch().count() >= _planner_deadline.load();
+        });
+        pathFinding(start_pt, target_pt, ptc, true);
+        _planner_running = false;
+    });
+}
+
+// stop the background planner, its best solution so far has already been published
+void cancelPathFinding()
+{
+    if (!_planner_thread.joinable())
+        return;
+
+    _planner_cancel = true;
+    _planner_thread.join();
+}
+
+// give the background planner [seconds] more time, measured from now if it had already run out
+void extendPathFinding(const double seconds)
+{
+    const long long now    = std::chrono::steady_clock::now().time_since_epoch().count();
+    const long long budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds)).count();
+
+    long long deadline = _planner_deadline.load();
+    while (!_planner_deadline.compare_exchange_weak(deadline, std::max(deadline, now) + budget))
+        ;
+}
+
+// ~cancel: stop the running anytime query
+void rcvCancelCallback(const std_msgs::Empty & msg)
+{
+    if( !_planner_running )
+    {
+        ROS_WARN("[node] no running query to cancel");
+        return;
+    }
+
+    cancelPathFinding();
+    ROS_INFO("[node] query cancelled");
+}
+
+// ~extend: give the running anytime query [msg.data] more seconds
+void rcvExtendCallback(const std_msgs::Float64 & msg)
+{
+    if( !_planner_running )
+    {
+        ROS_WARN("[node] no running query to extend");
+        return;
+    }
+
+    if( !(msg.data > 0.0) )
+    {
+        ROS_WARN("[node] extension of %f s is not positive, ignored", msg.data);
+        return;
+    }
+
+    extendPathFinding(msg.data);
+    ROS_INFO("[node] query extended by %f s", msg.data);
+}
+
 int main(int argc, char** argv)
 {
     ros::init(argc, argv, "demo_node");
@@ -259,6 +539,10 @@ int main(int argc, char** argv)
 
     _map_sub  = nh.subscribe( "map",       1, rcvPointCloudCallBack );
     _pts_sub  = nh.subscribe( "waypoints", 1, rcvWaypointsCallback );
+    _odom_sub = nh.subscribe( "odom",      1, rcvOdometryCallback );
+
+    _cancel_sub = nh.subscribe( "cancel", 1, rcvCancelCallback );
+    _extend_sub = nh.subscribe( "extend", 1, rcvExtendCallback );
 
     _grid_map_vis_pub             = nh.advertise<sensor_msgs::PointCloud2>("grid_map_vis", 1);
     _RRTstar_path_vis_pub         = nh.advertise<visualization_msgs::Marker>("RRTstar_path_vis",1);
@@ -275,6 +559,18 @@ int main(int argc, char** argv)
     nh.param("planning/start_y",  _start_pt(1),  0.0);
     nh.param("planning/start_z",  _start_pt(2),  0.0);
 
+    nh.param("planning/method",          _planning_method, std::string("rrt_star"));
+    nh.param("planning/roadmap_file",    _roadmap_file,    std::string("/tmp/grid_path_searcher_roadmap.bin"));
+    nh.param("planning/roadmap_samples", _roadmap_samples, 4000);
+
+    nh.param("planning/anytime",         _anytime_planning,     false);
+    nh.param("planning/time_budget",     _planning_time_budget, 1.0);
+
+    nh.param("replanning/rate",          _replan_rate,          10.0);
+    nh.param("replanning/time_budget",   _replan_time_budget,   0.08);
+    nh.param("replanning/max_step",      _replan_max_step,      1.0);
+    nh.param("replanning/max_nodes",     _replan_max_nodes,     20000);
+
     _map_lower << - _x_size/2.0, - _y_size/2.0,     0.0;
     _map_upper << + _x_size/2.0, + _y_size/2.0, _z_size;
     
@@ -286,6 +582,13 @@ int main(int argc, char** argv)
 
     _RRTstar_preparatory  = new RRTstarPreparatory();
     _RRTstar_preparatory  -> initGridMap(_resolution, _map_lower, _map_upper, _max_x_id, _max_y_id, _max_z_id);
+
+    if( _planning_method == "rrt_star_replanning" )
+    {
+        _replanning_rrt_star = new ReplanningRRTstar(_RRTstar_preparatory, _resolution, _map_lower, _map_upper);
+        _replanning_rrt_star -> setParam(_replan_max_step, 4.0 * _replan_max_step, 0.05, _replan_max_nodes);
+        _replan_timer = nh.createTimer(ros::Duration(1.0 / _replan_rate), replanCallback);
+    }
     
     ros::Rate rate(100);
     bool status = ros::ok();
@@ -296,6 +599,10 @@ int main(int argc, char** argv)
         rate.sleep();
     }
 
+    cancelPathFinding();
+
+    delete _replanning_rrt_star;
+    delete _lazy_prm_star;
     delete _RRTstar_preparatory;
     return 0;
 }
@@ -1,8 +1,19 @@
 #include <graph_searcher.h>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 using namespace std;
 using namespace Eigen;
 
+namespace {
+// the gather-based lookup reads 4 bytes per cell, keep the tail of the occupancy buffer addressable
+const int GatherPadding = 3;
+// points per batch when walking along a segment
+const int SegmentBatchSize = 64;
+}
+
 void RRTstarPreparatory::initGridMap(double _resolution, Vector3d global_xyz_l, Vector3d global_xyz_u, int max_x_id, int max_y_id, int max_z_id)
 {   
     gl_xl = global_xyz_l(0);
@@ -22,8 +33,8 @@ void RRTstarPreparatory::initGridMap(double _resolution, Vector3d global_xyz_l,
     resolution = _resolution;
     inv_resolution = 1.0 / _resolution;    
 
-    data = new uint8_t[GLXYZ_SIZE];
-    memset(data, 0, GLXYZ_SIZE * sizeof(uint8_t));
+    data = new uint8_t[GLXYZ_SIZE + GatherPadding];
+    memset(data, 0, (GLXYZ_SIZE + GatherPadding) * sizeof(uint8_t));
 }
 
 void RRTstarPreparatory::setObs(const double coord_x, const double coord_y, const double coord_z)
@@ -57,6 +68,88 @@ bool RRTstarPreparatory::isObsFree(const double coord_x, const double coord_y, c
            (data[idx_x * GLYZ_SIZE + idx_y * GLZ_SIZE + idx_z] < 1));
 }
 
+void RRTstarPreparatory::isObsFree(const double * coord_x, const double * coord_y, const double * coord_z, const int num, uint8_t * is_free)
+{
+    int i = 0;
+
+#ifdef __AVX2__
+    // 4 points per iteration: truncate & clamp exactly like coord2gridIndex, then gather the occupancy bytes
+    const __m256d lower_x = _mm256_set1_pd(gl_xl);
+    const __m256d lower_y = _mm256_set1_pd(gl_yl);
+    const __m256d lower_z = _mm256_set1_pd(gl_zl);
+    const __m256d inv_res = _mm256_set1_pd(inv_resolution);
+
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i max_x  = _mm_set1_epi32(GLX_SIZE - 1);
+    const __m128i max_y  = _mm_set1_epi32(GLY_SIZE - 1);
+    const __m128i max_z  = _mm_set1_epi32(GLZ_SIZE - 1);
+    const __m128i stride_x = _mm_set1_epi32(GLYZ_SIZE);
+    const __m128i stride_y = _mm_set1_epi32(GLZ_SIZE);
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+
+    for(; i + 4 <= num; i += 4)
+    {
+        __m128i idx_x = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(coord_x + i), lower_x), inv_res));
+        __m128i idx_y = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(coord_y + i), lower_y), inv_res));
+        __m128i idx_z = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(coord_z + i), lower_z), inv_res));
+
+        idx_x = _mm_min_epi32(_mm_max_epi32(idx_x, zero), max_x);
+        idx_y = _mm_min_epi32(_mm_max_epi32(idx_y, zero), max_y);
+        idx_z = _mm_min_epi32(_mm_max_epi32(idx_z, zero), max_z);
+
+        const __m128i address = _mm_add_epi32(
+            _mm_add_epi32(_mm_mullo_epi32(idx_x, stride_x), _mm_mullo_epi32(idx_y, stride_y)),
+            idx_z
+        );
+
+        const __m128i cells = _mm_and_si128(_mm_i32gather_epi32(reinterpret_cast<const int *>(data), address, 1), byte_mask);
+        const int free_mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(cells, zero)));
+
+        is_free[i + 0] = (free_mask >> 0) & 1;
+        is_free[i + 1] = (free_mask >> 1) & 1;
+        is_free[i + 2] = (free_mask >> 2) & 1;
+        is_free[i + 3] = (free_mask >> 3) & 1;
+    }
+#endif
+
+    for(; i < num; i++)
+    {
+        const int idx_x = min( max( int( (coord_x[i] - gl_xl) * inv_resolution), 0), GLX_SIZE - 1);
+        const int idx_y = min( max( int( (coord_y[i] - gl_yl) * inv_resolution), 0), GLY_SIZE - 1);
+        const int idx_z = min( max( int( (coord_z[i] - gl_zl) * inv_resolution), 0), GLZ_SIZE - 1);
+
+        is_free[i] = (data[idx_x * GLYZ_SIZE + idx_y * GLZ_SIZE + idx_z] < 1);
+    }
+}
+
+int RRTstarPreparatory::findFirstOccupied(const Vector3d & from, const Vector3d & to, const int num_steps, const int first_step)
+{
+    double  coord_x[SegmentBatchSize], coord_y[SegmentBatchSize], coord_z[SegmentBatchSize];
+    uint8_t is_free[SegmentBatchSize];
+
+    const Vector3d delta = (to - from) / double(max(num_steps, 1));
+
+    for(int batch_start = first_step; batch_start <= num_steps; batch_start += SegmentBatchSize)
+    {
+        const int batch_size = min(SegmentBatchSize, num_steps - batch_start + 1);
+
+        for(int j = 0; j < batch_size; j++)
+        {
+            const double step = double(batch_start + j);
+            coord_x[j] = from(0) + step * delta(0);
+            coord_y[j] = from(1) + step * delta(1);
+            coord_z[j] = from(2) + step * delta(2);
+        }
+
+        isObsFree(coord_x, coord_y, coord_z, batch_size, is_free);
+
+        for(int j = 0; j < batch_size; j++)
+            if( !is_free[j] ) return batch_start + j;
+    }
+
+    return -1;
+}
+
 Vector3d RRTstarPreparatory::gridIndex2coord(const Vector3i & index) 
 {
     Vector3d pt;
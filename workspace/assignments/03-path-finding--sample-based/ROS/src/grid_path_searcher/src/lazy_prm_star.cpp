@@ -0,0 +1,491 @@
+#include <lazy_prm_star.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <random>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace Eigen;
+
+constexpr char     LazyPRMstar::Magic[8];
+constexpr uint32_t LazyPRMstar::Version;
+
+namespace {
+// upper bound on search / validate rounds per query, each round invalidates at least one edge or vertex
+const int MaxLazyIterations = 1000;
+
+// k-nearest connection rule of PRM* in 3D, k = e * (1 + 1/d) * log(n)
+size_t getPRMstarK(const size_t n)
+{
+    return max<size_t>(1, static_cast<size_t>(ceil(M_E * (1.0 + 1.0 / 3.0) * log(max<size_t>(n, 2)))));
+}
+}
+
+LazyPRMstar::LazyPRMstar(RRTstarPreparatory * _grid, double _resolution, Vector3d global_xyz_l, Vector3d global_xyz_u) :
+    grid(_grid), lower(global_xyz_l), upper(global_xyz_u), resolution(_resolution),
+    mapped(nullptr), mapped_size(0), num_vertices(0), num_edges(0),
+    vertices(nullptr), offsets(nullptr), adjacency(nullptr), vertex_state(nullptr), edge_state(nullptr)
+{
+}
+
+LazyPRMstar::~LazyPRMstar()
+{
+    unmap();
+}
+
+void LazyPRMstar::computeLayout(
+    const uint32_t n_vertices, const uint64_t n_edges,
+    size_t & vertices_offset, size_t & offsets_offset, size_t & adjacency_offset,
+    size_t & vertex_state_offset, size_t & edge_state_offset, size_t & file_size
+)
+{
+    vertices_offset     = alignUp(sizeof(RoadmapHeader));
+    offsets_offset      = alignUp(vertices_offset + 3 * sizeof(double) * n_vertices);
+    adjacency_offset    = alignUp(offsets_offset + sizeof(uint32_t) * (n_vertices + 1));
+    vertex_state_offset = alignUp(adjacency_offset + sizeof(uint32_t) * n_edges);
+    edge_state_offset   = alignUp(vertex_state_offset + n_vertices);
+    file_size           = alignUp(edge_state_offset + n_edges);
+}
+
+bool LazyPRMstar::build(const string & roadmap_file, const int num_samples, const unsigned int seed)
+{
+    if( num_samples < 2 )
+        return false;
+
+    const uint32_t n = static_cast<uint32_t>(num_samples);
+    const size_t   k = min<size_t>(getPRMstarK(n), n - 1);
+
+    // 1. sample vertices uniformly over the map, the lazy variant does not check them here:
+    mt19937 generator(seed);
+    uniform_real_distribution<double> rand_x(lower(0), upper(0));
+    uniform_real_distribution<double> rand_y(lower(1), upper(1));
+    uniform_real_distribution<double> rand_z(lower(2), upper(2));
+
+    vector<double> samples(3 * n);
+    for(uint32_t v = 0; v < n; v++)
+    {
+        samples[3 * v + 0] = rand_x(generator);
+        samples[3 * v + 1] = rand_y(generator);
+        samples[3 * v + 2] = rand_z(generator);
+    }
+
+    // 2. connect each vertex to its k nearest neighbours, symmetrised:
+    vector<vector<uint32_t>> neighbors(n);
+    vector<pair<double, uint32_t>> candidates;
+    candidates.reserve(n);
+    for(uint32_t u = 0; u < n; u++)
+    {
+        candidates.clear();
+        for(uint32_t v = 0; v < n; v++)
+        {
+            if( v == u ) continue;
+
+            const double dx = samples[3 * v + 0] - samples[3 * u + 0];
+            const double dy = samples[3 * v + 1] - samples[3 * u + 1];
+            const double dz = samples[3 * v + 2] - samples[3 * u + 2];
+            candidates.emplace_back(dx * dx + dy * dy + dz * dz, v);
+        }
+        nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end());
+
+        for(size_t i = 0; i < k; i++)
+        {
+            neighbors[u].push_back(candidates[i].second);
+            neighbors[candidates[i].second].push_back(u);
+        }
+    }
+
+    vector<uint32_t> csr_offsets(n + 1, 0);
+    for(uint32_t u = 0; u < n; u++)
+    {
+        sort(neighbors[u].begin(), neighbors[u].end());
+        neighbors[u].erase(unique(neighbors[u].begin(), neighbors[u].end()), neighbors[u].end());
+        csr_offsets[u + 1] = csr_offsets[u] + neighbors[u].size();
+    }
+    const uint64_t n_edges = csr_offsets[n];
+
+    // 3. serialise:
+    size_t vertices_offset, offsets_offset, adjacency_offset, vertex_state_offset, edge_state_offset, file_size;
+    computeLayout(n, n_edges, vertices_offset, offsets_offset, adjacency_offset, vertex_state_offset, edge_state_offset, file_size);
+
+    vector<char> buffer(file_size, 0);
+
+    RoadmapHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, Magic, sizeof(header.magic));
+    header.version      = Version;
+    header.num_vertices = n;
+    header.num_edges    = n_edges;
+    header.file_size    = file_size;
+    for(int i = 0; i < 3; i++)
+    {
+        header.lower[i] = lower(i);
+        header.upper[i] = upper(i);
+    }
+    header.resolution = resolution;
+
+    memcpy(buffer.data(), &header, sizeof(header));
+    memcpy(buffer.data() + vertices_offset, samples.data(), samples.size() * sizeof(double));
+    memcpy(buffer.data() + offsets_offset, csr_offsets.data(), csr_offsets.size() * sizeof(uint32_t));
+
+    uint32_t * csr_adjacency = reinterpret_cast<uint32_t *>(buffer.data() + adjacency_offset);
+    for(uint32_t u = 0; u < n; u++)
+        copy(neighbors[u].begin(), neighbors[u].end(), csr_adjacency + csr_offsets[u]);
+
+    // vertex / edge states stay zero, i.e. Unknown
+
+    ofstream output(roadmap_file.c_str(), ios::binary | ios::trunc);
+    if( !output )
+    {
+        ROS_WARN("[LazyPRMstar] failed to open %s for writing", roadmap_file.c_str());
+        return false;
+    }
+    output.write(buffer.data(), buffer.size());
+    if( !output )
+    {
+        ROS_WARN("[LazyPRMstar] failed to write %s", roadmap_file.c_str());
+        return false;
+    }
+
+    ROS_INFO("[LazyPRMstar] roadmap with %u vertices, %lu edges written to %s",
+        n, static_cast<unsigned long>(n_edges / 2), roadmap_file.c_str());
+
+    return true;
+}
+
+bool LazyPRMstar::load(const string & roadmap_file)
+{
+    unmap();
+
+    int fd = open(roadmap_file.c_str(), O_RDONLY);
+    if( fd < 0 )
+        return false;
+
+    struct stat file_stat;
+    if( fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(RoadmapHeader) )
+    {
+        close(fd);
+        return false;
+    }
+
+    // private writable mapping: validity results land in copy-on-write pages and never reach the file
+    void * region = mmap(nullptr, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if( region == MAP_FAILED )
+    {
+        ROS_WARN("[LazyPRMstar] failed to map %s", roadmap_file.c_str());
+        return false;
+    }
+
+    mapped      = region;
+    mapped_size = file_stat.st_size;
+
+    const RoadmapHeader * header = static_cast<const RoadmapHeader *>(mapped);
+
+    size_t vertices_offset, offsets_offset, adjacency_offset, vertex_state_offset, edge_state_offset, file_size;
+    bool consistent = ( memcmp(header->magic, Magic, sizeof(header->magic)) == 0 && header->version == Version );
+    if( consistent )
+    {
+        computeLayout(header->num_vertices, header->num_edges, vertices_offset, offsets_offset, adjacency_offset, vertex_state_offset, edge_state_offset, file_size);
+        consistent = ( header->file_size == file_size && mapped_size == file_size );
+    }
+    for(int i = 0; consistent && i < 3; i++)
+    {
+        consistent = ( fabs(header->lower[i] - lower(i)) < 1e-6 && fabs(header->upper[i] - upper(i)) < 1e-6 );
+    }
+    if( !consistent || fabs(header->resolution - resolution) > 1e-6 )
+    {
+        ROS_WARN("[LazyPRMstar] %s does not match the current map, ignored", roadmap_file.c_str());
+        unmap();
+        return false;
+    }
+
+    char * base  = static_cast<char *>(mapped);
+    num_vertices = header->num_vertices;
+    num_edges    = header->num_edges;
+    vertices     = reinterpret_cast<const double *>(base + vertices_offset);
+    offsets      = reinterpret_cast<const uint32_t *>(base + offsets_offset);
+    adjacency    = reinterpret_cast<const uint32_t *>(base + adjacency_offset);
+    vertex_state = reinterpret_cast<uint8_t *>(base + vertex_state_offset);
+    edge_state   = reinterpret_cast<uint8_t *>(base + edge_state_offset);
+
+    g_score.resize(num_vertices + 2);
+    came_from.resize(num_vertices + 2);
+    closed.resize(num_vertices + 2);
+    goal_linked.assign(num_vertices, 0);
+
+    ROS_INFO("[LazyPRMstar] roadmap with %u vertices mapped from %s", num_vertices, roadmap_file.c_str());
+
+    return true;
+}
+
+void LazyPRMstar::unmap()
+{
+    if( mapped != nullptr )
+        munmap(mapped, mapped_size);
+
+    mapped       = nullptr;
+    mapped_size  = 0;
+    num_vertices = 0;
+    num_edges    = 0;
+    vertices     = nullptr;
+    offsets      = nullptr;
+    adjacency    = nullptr;
+    vertex_state = nullptr;
+    edge_state   = nullptr;
+}
+
+void LazyPRMstar::resetValidation()
+{
+    if( !isLoaded() ) return;
+
+    memset(vertex_state, Unknown, num_vertices);
+    memset(edge_state,   Unknown, num_edges);
+}
+
+bool LazyPRMstar::isSegmentFree(const Vector3d & from, const Vector3d & to)
+{
+    const int num_steps = max(1, static_cast<int>(ceil((to - from).norm() / (0.5 * resolution))));
+
+    return grid->findFirstOccupied(from, to, num_steps) < 0;
+}
+
+bool LazyPRMstar::isVertexValid(const uint32_t v)
+{
+    if( vertex_state[v] == Unknown )
+    {
+        const Vector3d pt = vertex(v);
+        vertex_state[v] = grid->isObsFree(pt(0), pt(1), pt(2)) ? Valid : Invalid;
+    }
+
+    return vertex_state[v] == Valid;
+}
+
+void LazyPRMstar::setEdgeState(const uint32_t u, const uint32_t v, const ValidityState state)
+{
+    for(uint32_t e = offsets[u]; e < offsets[u + 1]; e++)
+        if( adjacency[e] == v ) edge_state[e] = state;
+
+    for(uint32_t e = offsets[v]; e < offsets[v + 1]; e++)
+        if( adjacency[e] == u ) edge_state[e] = state;
+}
+
+bool LazyPRMstar::isEdgeValid(const uint32_t u, const uint64_t e)
+{
+    if( edge_state[e] == Unknown )
+    {
+        const uint32_t v = adjacency[e];
+        setEdgeState(u, v, isSegmentFree(vertex(u), vertex(v)) ? Valid : Invalid);
+    }
+
+    return edge_state[e] == Valid;
+}
+
+void LazyPRMstar::validateIncidentEdges(const uint32_t u)
+{
+    for(uint32_t e = offsets[u]; e < offsets[u + 1]; e++)
+    {
+        if( isVertexValid(adjacency[e]) )
+            isEdgeValid(u, e);
+    }
+}
+
+void LazyPRMstar::findNearest(const Vector3d & pt, const size_t k, vector<uint32_t> & nearest) const
+{
+    // bounded max-heap over squared distance:
+    priority_queue<pair<double, uint32_t>> heap;
+
+    for(uint32_t v = 0; v < num_vertices; v++)
+    {
+        const double dx = vertices[3 * v + 0] - pt(0);
+        const double dy = vertices[3 * v + 1] - pt(1);
+        const double dz = vertices[3 * v + 2] - pt(2);
+        const double dist = dx * dx + dy * dy + dz * dz;
+
+        if( heap.size() < k )
+            heap.emplace(dist, v);
+        else if( dist < heap.top().first )
+        {
+            heap.pop();
+            heap.emplace(dist, v);
+        }
+    }
+
+    nearest.clear();
+    while( !heap.empty() )
+    {
+        nearest.push_back(heap.top().second);
+        heap.pop();
+    }
+    reverse(nearest.begin(), nearest.end());
+}
+
+void LazyPRMstar::linkToRoadmap(const Vector3d & pt, vector<uint32_t> & links)
+{
+    vector<uint32_t> nearest;
+    findNearest(pt, getPRMstarK(num_vertices), nearest);
+
+    // query endpoints are connected eagerly, there are only k of them:
+    links.clear();
+    for(size_t i = 0; i < nearest.size(); i++)
+    {
+        if( isVertexValid(nearest[i]) && isSegmentFree(pt, vertex(nearest[i])) )
+            links.push_back(nearest[i]);
+    }
+}
+
+bool LazyPRMstar::searchGraph(const Vector3d & start_pt, const Vector3d & target_pt, vector<int> & vertex_path)
+{
+    const int start_id  = num_vertices;
+    const int target_id = num_vertices + 1;
+
+    auto position = [&](const int id) -> Vector3d {
+        if( id == start_id )  return start_pt;
+        if( id == target_id ) return target_pt;
+        return vertex(id);
+    };
+
+    fill(g_score.begin(), g_score.end(), numeric_limits<double>::infinity());
+    fill(came_from.begin(), came_from.end(), -1);
+    fill(closed.begin(), closed.end(), 0);
+
+    typedef pair<double, int> QueueItem;
+    priority_queue<QueueItem, vector<QueueItem>, greater<QueueItem>> open_set;
+
+    auto relax = [&](const int from, const int to) {
+        if( closed[to] ) return;
+
+        const Vector3d to_pt = position(to);
+        const double tentative = g_score[from] + (to_pt - position(from)).norm();
+        if( tentative < g_score[to] )
+        {
+            g_score[to]   = tentative;
+            came_from[to] = from;
+            open_set.emplace(tentative + (target_pt - to_pt).norm(), to);
+        }
+    };
+
+    g_score[start_id] = 0.0;
+    open_set.emplace((target_pt - start_pt).norm(), start_id);
+
+    while( !open_set.empty() )
+    {
+        const int current = open_set.top().second;
+        open_set.pop();
+
+        if( closed[current] ) continue;
+        closed[current] = 1;
+
+        if( current == target_id )
+        {
+            vertex_path.clear();
+            for(int id = target_id; id != -1; id = came_from[id])
+                vertex_path.push_back(id);
+            reverse(vertex_path.begin(), vertex_path.end());
+            return true;
+        }
+
+        if( current == start_id )
+        {
+            for(size_t i = 0; i < start_links.size(); i++)
+                relax(current, start_links[i]);
+            continue;
+        }
+
+        for(uint32_t e = offsets[current]; e < offsets[current + 1]; e++)
+        {
+            const uint32_t next = adjacency[e];
+            // skip only what is already known to be in collision, the rest is checked lazily:
+            if( edge_state[e] == Invalid || vertex_state[next] == Invalid ) continue;
+            relax(current, next);
+        }
+
+        if( goal_linked[current] )
+            relax(current, target_id);
+    }
+
+    return false;
+}
+
+bool LazyPRMstar::query(const Vector3d & start_pt, const Vector3d & target_pt, vector<Vector3d> & path)
+{
+    path.clear();
+
+    if( !isLoaded() )
+        return false;
+
+    if( isSegmentFree(start_pt, target_pt) )
+    {
+        path.push_back(start_pt);
+        path.push_back(target_pt);
+        return true;
+    }
+
+    linkToRoadmap(start_pt,  start_links);
+    linkToRoadmap(target_pt, goal_links);
+    if( start_links.empty() || goal_links.empty() )
+    {
+        ROS_WARN("[LazyPRMstar] failed to connect %s to the roadmap", start_links.empty() ? "start" : "target");
+        return false;
+    }
+
+    for(size_t i = 0; i < goal_links.size(); i++)
+        goal_linked[goal_links[i]] = 1;
+
+    bool found = false;
+    vector<int> vertex_path;
+    for(int iter = 0; iter < MaxLazyIterations && !found; iter++)
+    {
+        if( !searchGraph(start_pt, target_pt, vertex_path) )
+            break;
+
+        // validate the whole candidate so that one round removes every conflict on it, vertices first
+        // as they are cheap. links to start / target are already known to be free:
+        found = true;
+        for(size_t i = 1; i + 1 < vertex_path.size(); i++)
+            found = isVertexValid(vertex_path[i]) && found;
+
+        for(size_t i = 1; i + 2 < vertex_path.size(); i++)
+        {
+            const uint32_t u = vertex_path[i];
+            const uint32_t v = vertex_path[i + 1];
+
+            for(uint32_t e = offsets[u]; e < offsets[u + 1]; e++)
+            {
+                if( adjacency[e] == v )
+                {
+                    if( !isEdgeValid(u, e) )
+                    {
+                        // a blocked edge usually has blocked siblings, settle them now instead of
+                        // paying one more graph search for each of them:
+                        validateIncidentEdges(u);
+                        validateIncidentEdges(v);
+                        found = false;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    for(size_t i = 0; i < goal_links.size(); i++)
+        goal_linked[goal_links[i]] = 0;
+
+    if( !found )
+        return false;
+
+    path.push_back(start_pt);
+    for(size_t i = 1; i + 1 < vertex_path.size(); i++)
+        path.push_back(vertex(vertex_path[i]));
+    path.push_back(target_pt);
+
+    return true;
+}
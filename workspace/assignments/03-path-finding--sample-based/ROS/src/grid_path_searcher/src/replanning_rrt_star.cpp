@@ -0,0 +1,407 @@
+#include <replanning_rrt_star.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace Eigen;
+
+namespace {
+// number of nearest tree nodes tried as the new child of the root before the tree is dropped
+const int MaxAnchorCandidates = 32;
+// number of random nodes tried as the leaf recycled by a full tree before falling back to a scan
+const int MaxLeafCandidates = 64;
+}
+
+ReplanningRRTstar::ReplanningRRTstar(RRTstarPreparatory * _grid, double _resolution, Vector3d global_xyz_l, Vector3d global_xyz_u) :
+    grid(_grid), lower(global_xyz_l), upper(global_xyz_u), resolution(_resolution),
+    max_step(1.0), gamma(4.0), goal_bias(0.05), max_nodes(20000),
+    target(Vector3d::Zero()), goal_id(-1), map_changed(false), generator(0)
+{
+}
+
+void ReplanningRRTstar::setParam(double _max_step, double _gamma, double _goal_bias, int _max_nodes)
+{
+    max_step  = _max_step;
+    gamma     = _gamma;
+    goal_bias = _goal_bias;
+    max_nodes = _max_nodes;
+}
+
+void ReplanningRRTstar::reset()
+{
+    positions.clear();
+    nodes.clear();
+    goal_id = -1;
+}
+
+double ReplanningRRTstar::getSearchRadius() const
+{
+    const double n = double(nodes.size() + 1);
+    return min(max_step, gamma * pow(log(n) / n, 1.0 / 3.0));
+}
+
+bool ReplanningRRTstar::isSegmentFree(const Vector3d & from, const Vector3d & to)
+{
+    const int num_steps = max(1, static_cast<int>(ceil((to - from).norm() / (0.5 * resolution))));
+
+    return grid->findFirstOccupied(from, to, num_steps) < 0;
+}
+
+int ReplanningRRTstar::findNearest(const Vector3d & pt) const
+{
+    int nearest = -1;
+    double min_dist = numeric_limits<double>::infinity();
+
+    for(int i = 0; i < int(positions.size()); i++)
+    {
+        const double dist = (positions[i] - pt).squaredNorm();
+        if( dist < min_dist )
+        {
+            min_dist = dist;
+            nearest  = i;
+        }
+    }
+
+    return nearest;
+}
+
+void ReplanningRRTstar::findNear(const Vector3d & pt, const double radius, vector<int> & ids) const
+{
+    ids.clear();
+
+    const double radius_squared = radius * radius;
+    for(int i = 0; i < int(positions.size()); i++)
+    {
+        if( (positions[i] - pt).squaredNorm() <= radius_squared )
+            ids.push_back(i);
+    }
+}
+
+int ReplanningRRTstar::addNode(const Vector3d & pt, const int parent, const double cost)
+{
+    const int id = nodes.size();
+
+    positions.push_back(pt);
+    nodes.push_back(TreeNode());
+    nodes[id].cost   = cost;
+    nodes[id].parent = parent;
+    if( parent >= 0 )
+        nodes[parent].children.push_back(id);
+
+    return id;
+}
+
+void ReplanningRRTstar::reparent(const int node_id, const int parent_id, const double cost)
+{
+    TreeNode & node = nodes[node_id];
+
+    vector<int> & siblings = nodes[node.parent].children;
+    siblings.erase(remove(siblings.begin(), siblings.end(), node_id), siblings.end());
+    nodes[parent_id].children.push_back(node_id);
+
+    const double delta = cost - node.cost;
+    node.parent = parent_id;
+
+    // propagate the cost change to the whole subtree:
+    vector<int> open_list(1, node_id);
+    while( !open_list.empty() )
+    {
+        const int id = open_list.back();
+        open_list.pop_back();
+
+        nodes[id].cost += delta;
+        open_list.insert(open_list.end(), nodes[id].children.begin(), nodes[id].children.end());
+    }
+}
+
+// remove a leaf, the last node takes over its id
+void ReplanningRRTstar::removeLeaf(const int node_id)
+{
+    vector<int> & siblings = nodes[nodes[node_id].parent].children;
+    siblings.erase(remove(siblings.begin(), siblings.end(), node_id), siblings.end());
+
+    const int last = nodes.size() - 1;
+    if( node_id != last )
+    {
+        positions[node_id] = positions[last];
+        swap(nodes[node_id], nodes[last]);
+
+        vector<int> & last_siblings = nodes[nodes[node_id].parent].children;
+        replace(last_siblings.begin(), last_siblings.end(), last, node_id);
+        for(const int c : nodes[node_id].children)
+            nodes[c].parent = node_id;
+
+        if( goal_id == last )
+            goal_id = node_id;
+    }
+
+    positions.pop_back();
+    nodes.pop_back();
+}
+
+// make room in a full tree by removing a random leaf other than [keep_id] & the target. the path to the
+// target only ends in a leaf at the target itself, so it is never shortened
+bool ReplanningRRTstar::recycleLeaf(const int keep_id)
+{
+    const auto is_recyclable = [this, keep_id](const int i)
+    {
+        return i != 0 && i != keep_id && i != goal_id && nodes[i].children.empty();
+    };
+
+    uniform_int_distribution<int> rand_id(1, int(nodes.size()) - 1);
+    for(int i = 0; i < MaxLeafCandidates; i++)
+    {
+        const int id = rand_id(generator);
+        if( is_recyclable(id) )
+        {
+            removeLeaf(id);
+            return true;
+        }
+    }
+
+    for(int id = 1; id < int(nodes.size()); id++)
+    {
+        if( is_recyclable(id) )
+        {
+            removeLeaf(id);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ReplanningRRTstar::pruneInvalidEdges(vector<uint8_t> & edge_valid)
+{
+    // edge_valid[i] refers to the edge between node i and its parent
+    edge_valid.assign(nodes.size(), 1);
+    if( !map_changed )
+        return;
+
+    int num_invalid = 0;
+    for(int i = 0; i < int(nodes.size()); i++)
+    {
+        if( nodes[i].parent >= 0 && !isSegmentFree(positions[nodes[i].parent], positions[i]) )
+        {
+            edge_valid[i] = 0;
+            num_invalid++;
+        }
+    }
+
+    ROS_INFO("[ReplanningRRTstar] %d of %d tree edges invalidated by the new map", num_invalid, int(nodes.size()) - 1);
+}
+
+bool ReplanningRRTstar::reroot(const Vector3d & start_pt)
+{
+    // nothing to do if neither the start nor the map has changed:
+    if( !map_changed && (positions[0] - start_pt).norm() < 1e-6 )
+        return true;
+
+    vector<uint8_t> edge_valid;
+    pruneInvalidEdges(edge_valid);
+
+    // the new root gets a single child, the nearest node which can be reached from the start:
+    candidates.clear();
+    for(int i = 0; i < int(positions.size()); i++)
+        candidates.push_back(make_pair((positions[i] - start_pt).squaredNorm(), i));
+
+    const int num_anchor_candidates = min<int>(MaxAnchorCandidates, candidates.size());
+    partial_sort(candidates.begin(), candidates.begin() + num_anchor_candidates, candidates.end());
+
+    int anchor = -1;
+    for(int i = 0; i < num_anchor_candidates; i++)
+    {
+        if( isSegmentFree(start_pt, positions[candidates[i].second]) )
+        {
+            anchor = candidates[i].second;
+            break;
+        }
+    }
+    if( anchor < 0 )
+        return false;
+
+    //
+    // breadth-first traversal of the valid tree edges, ignoring their direction, starting from the anchor.
+    // the traversal order is the new node order, so parents always precede their children
+    //
+    vector<int> new_id(nodes.size(), -1);
+    vector<int> order(1, anchor), new_parent(1, 0);
+    new_id[anchor] = 1;
+
+    for(size_t head = 0; head < order.size(); head++)
+    {
+        const int u = order[head];
+
+        if( nodes[u].parent >= 0 && edge_valid[u] && new_id[nodes[u].parent] < 0 )
+        {
+            new_id[nodes[u].parent] = order.size() + 1;
+            order.push_back(nodes[u].parent);
+            new_parent.push_back(head + 1);
+        }
+        for(const int c : nodes[u].children)
+        {
+            if( edge_valid[c] && new_id[c] < 0 )
+            {
+                new_id[c] = order.size() + 1;
+                order.push_back(c);
+                new_parent.push_back(head + 1);
+            }
+        }
+    }
+
+    // node 0 is the new start:
+    vector<Vector3d> new_positions(1, start_pt);
+    vector<TreeNode> new_nodes(order.size() + 1);
+    new_positions.reserve(order.size() + 1);
+
+    for(size_t i = 0; i < order.size(); i++)
+    {
+        const int id     = i + 1;
+        const int parent = new_parent[i];
+
+        new_positions.push_back(positions[order[i]]);
+        new_nodes[id].parent = parent;
+        new_nodes[id].cost   = new_nodes[parent].cost + (new_positions[id] - new_positions[parent]).norm();
+        new_nodes[parent].children.push_back(id);
+    }
+
+    ROS_INFO("[ReplanningRRTstar] re-rooted, kept %d of %d nodes", int(order.size()), int(nodes.size()));
+
+    goal_id = goal_id >= 0 ? new_id[goal_id] : -1;
+    positions.swap(new_positions);
+    nodes.swap(new_nodes);
+
+    return true;
+}
+
+void ReplanningRRTstar::extend()
+{
+    uniform_real_distribution<double> rand_x(lower(0), upper(0));
+    uniform_real_distribution<double> rand_y(lower(1), upper(1));
+    uniform_real_distribution<double> rand_z(lower(2), upper(2));
+    uniform_real_distribution<double> rand_unit(0.0, 1.0);
+
+    // 1. sample:
+    const bool to_goal = rand_unit(generator) < goal_bias;
+
+    Vector3d sample;
+    if( to_goal )
+        sample = target;
+    else
+        sample << rand_x(generator), rand_y(generator), rand_z(generator);
+
+    const double radius = getSearchRadius();
+
+    // 2. once the target is in the tree, goal samples only rewire it:
+    if( to_goal && goal_id >= 0 )
+    {
+        findNear(target, radius, near_ids);
+        for(const int i : near_ids)
+        {
+            const double cost = nodes[i].cost + (positions[i] - target).norm();
+            // descendants of the goal cost more than the goal itself, so this cannot create a cycle
+            if( cost < nodes[goal_id].cost && isSegmentFree(positions[i], target) )
+                reparent(goal_id, i, cost);
+        }
+        return;
+    }
+
+    // 3. steer from the nearest node:
+    const int nearest = findNearest(sample);
+    const Vector3d delta = sample - positions[nearest];
+    const double dist = delta.norm();
+    if( dist < 1e-9 )
+        return;
+
+    const bool reach_goal = to_goal && dist <= max_step;
+    const Vector3d new_pt = dist > max_step ? Vector3d(positions[nearest] + delta * (max_step / dist)) : sample;
+
+    if( !grid->isObsFree(new_pt(0), new_pt(1), new_pt(2)) )
+        return;
+
+    // 4. choose parent among the near nodes, cheapest first:
+    findNear(new_pt, radius, near_ids);
+    if( find(near_ids.begin(), near_ids.end(), nearest) == near_ids.end() )
+        near_ids.push_back(nearest);
+
+    candidates.clear();
+    for(const int i : near_ids)
+        candidates.push_back(make_pair(nodes[i].cost + (positions[i] - new_pt).norm(), i));
+    sort(candidates.begin(), candidates.end());
+
+    int chosen = -1;
+    for(int i = 0; i < int(candidates.size()); i++)
+    {
+        if( isSegmentFree(positions[candidates[i].second], new_pt) )
+        {
+            chosen = i;
+            break;
+        }
+    }
+    if( chosen < 0 )
+        return;
+
+    const int new_id = addNode(new_pt, candidates[chosen].second, candidates[chosen].first);
+    if( reach_goal )
+        goal_id = new_id;
+
+    // 5. rewire through the new node. it is a leaf, so no cycle can be created:
+    for(const int i : near_ids)
+    {
+        if( i == nodes[new_id].parent )
+            continue;
+
+        const double cost = nodes[new_id].cost + (positions[i] - new_pt).norm();
+        if( cost < nodes[i].cost && isSegmentFree(new_pt, positions[i]) )
+            reparent(i, new_id, cost);
+    }
+
+    // 6. a full tree keeps its size, so refinement goes on after it has reached max_nodes:
+    while( int(nodes.size()) > max_nodes && recycleLeaf(new_id) )
+        ;
+}
+
+bool ReplanningRRTstar::plan(const Vector3d & start_pt, const Vector3d & target_pt, const double time_budget, vector<Vector3d> & path)
+{
+    const auto time_start = chrono::steady_clock::now();
+
+    path.clear();
+
+    if( !grid->isObsFree(target_pt(0), target_pt(1), target_pt(2)) )
+    {
+        ROS_WARN("[ReplanningRRTstar] target is occupied");
+        return false;
+    }
+
+    // keep the tree only if it was grown towards the same target:
+    const bool reuse = !nodes.empty() && (target_pt - target).norm() < 0.5 * resolution && reroot(start_pt);
+    if( !reuse )
+    {
+        reset();
+        addNode(start_pt, -1, 0.0);
+        target = target_pt;
+    }
+    map_changed = false;
+
+    while( chrono::duration<double>(chrono::steady_clock::now() - time_start).count() < time_budget )
+        extend();
+
+    ROS_INFO("[ReplanningRRTstar] %d nodes, best cost %.3f", int(nodes.size()), getCost());
+
+    if( goal_id < 0 )
+        return false;
+
+    for(int id = goal_id; id >= 0; id = nodes[id].parent)
+        path.push_back(positions[id]);
+    reverse(path.begin(), path.end());
+
+    return true;
+}
+
+double ReplanningRRTstar::getCost() const
+{
+    return goal_id >= 0 ? nodes[goal_id].cost : numeric_limits<double>::infinity();
+}
@@ -24,18 +24,35 @@ class Homeworktool
 		double gl_xu, gl_yu, gl_zu;	
 
 		Eigen::Vector3d gridIndex2coord(const Eigen::Vector3i & index);
-		Eigen::Vector3i coord2gridIndex(const Eigen::Vector3d & pt);
 
 	public:
 		Homeworktool(){};
 		~Homeworktool(){};
 
 		void initGridMap(double _resolution, Eigen::Vector3d global_xyz_l, Eigen::Vector3d global_xyz_u, int max_x_id, int max_y_id, int max_z_id);
-		void setObs(const double coord_x, const double coord_y, const double coord_z);
+		// true if the voxel was free before
+		bool setObs(const double coord_x, const double coord_y, const double coord_z);
 		bool isObsFree(const double coord_x, const double coord_y, const double coord_z);
+
+		// index of the voxel containing pt, clamped to the map
+		Eigen::Vector3i coord2gridIndex(const Eigen::Vector3d & pt);
+
+		// occupancy by voxel index, voxels outside the map are occupied
+		bool isObsFree(const Eigen::Vector3i & index) const {
+			return index(0) >= 0 && index(0) < GLX_SIZE && index(1) >= 0 && index(1) < GLY_SIZE && index(2) >= 0 && index(2) < GLZ_SIZE &&
+			       data[index(0) * GLYZ_SIZE + index(1) * GLZ_SIZE + index(2)] < 1;
+		}
 				
 		Eigen::Vector3d coordRounding(const Eigen::Vector3d & coord);
 		double OptimalBVP(Eigen::Vector3d _start_position,Eigen::Vector3d _start_velocity,Eigen::Vector3d _target_position);
+
+		// OBVP of the double integrator with fixed final state, cost J = T + integral of |a|^2.
+		// returns the optimal cost, or infinity if there is no positive duration, and the optimal duration T
+		static double OptimalBVP(
+			const Eigen::Vector3d & start_position, const Eigen::Vector3d & start_velocity,
+			const Eigen::Vector3d & target_position, const Eigen::Vector3d & target_velocity,
+			double & optimal_time
+		);
 };
 
 #endif
\ No newline at end of file
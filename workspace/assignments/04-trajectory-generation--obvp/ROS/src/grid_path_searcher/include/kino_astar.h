@@ -0,0 +1,95 @@
+#ifndef _KINO_ASTAR_H_
+#define _KINO_ASTAR_H_
+
+#include <iostream>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <Eigen/Eigen>
+#include "backward.hpp"
+#include <hw_tool.h>
+#include <trajectory_library.h>
+
+// hybrid-state A* over constant-acceleration motion primitives of the double integrator.
+//
+// every expansion rolls the whole acceleration lattice out of the current state with TrajectoryLibrary.
+// states are merged in a closed set hashed on their position voxel and quantised velocity, while the
+// nodes themselves keep the continuous state they were reached with. the heuristic is the OBVP cost to
+// the goal state, and the optimal OBVP trajectory to the goal is tried as an analytic shot on every
+// expansion, so the search usually ends well before a primitive lands on the goal.
+class KinoAstar
+{
+	private:
+		struct KinoState
+		{
+			Eigen::Vector3d pos, vel;
+			Eigen::Vector3d input;        // acceleration of the primitive from the parent
+			double g_score;
+			double f_score;               // priority of the latest open set entry, older entries are stale
+			int parent;
+			bool closed;
+		};
+
+		Homeworktool * homework_tool;
+
+		Eigen::Vector3d lower, upper;
+		double resolution;
+
+		double max_vel, max_acc;
+		double primitive_time;
+		double vel_resolution;
+		double heuristic_weight;
+		int    discretize_step;
+		int    max_expansions;
+
+		// bits per axis of the position voxel & velocity cell indices in the closed set keys, derived from the
+		// map size & the velocity range so that distinct cells never share a key
+		int    pos_bits, vel_bits;
+
+		// primitives of the current expansion, the acceleration lattice is set once
+		TrajectoryLibrary primitives;
+
+		std::vector<KinoState> states;
+		std::unordered_map<int64_t, int> state_index;
+		std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<std::pair<double, int>>> open_set;
+
+		// the analytic shot from the last node of the search to the goal
+		int    shot_from;
+		double shot_time;
+		Eigen::Vector3d goal_pos, goal_vel;
+
+		void    updateKeyLayout();
+		int64_t getStateKey(const Eigen::Vector3d & pos, const Eigen::Vector3d & vel) const;
+		double  getHeuristic(const Eigen::Vector3d & pos, const Eigen::Vector3d & vel, double & optimal_time) const;
+
+		bool isPrimitiveFeasible(const int primitive);
+		bool isShotFeasible(const Eigen::Vector3d & pos, const Eigen::Vector3d & vel, const double T) const;
+
+	public:
+		KinoAstar(Homeworktool * _homework_tool, double _resolution, Eigen::Vector3d global_xyz_l, Eigen::Vector3d global_xyz_u);
+		~KinoAstar(){};
+
+		// [_max_vel] and [_max_acc] bound every component of velocity and acceleration, every primitive lasts
+		// [_primitive_time] seconds and the lattice has [_discretize_step] + 1 inputs per axis. the closed set
+		// quantises velocity with [_vel_resolution], the OBVP heuristic is inflated by [_heuristic_weight].
+		// a velocity resolution too fine for the 63 bits of a key is coarsened to the finest one which fits
+		void setParam(
+			double _max_vel, double _max_acc, double _primitive_time, int _discretize_step,
+			double _vel_resolution, double _heuristic_weight, int _max_expansions
+		);
+
+		// search a trajectory from the start state to the goal state, true if one is found
+		bool plan(
+			const Eigen::Vector3d & start_pos, const Eigen::Vector3d & start_vel,
+			const Eigen::Vector3d & target_pos, const Eigen::Vector3d & target_vel
+		);
+
+		int getNumStates() const { return states.size(); }
+
+		// sample the trajectory every [delta_time] seconds
+		void getTrajectory(const double delta_time, std::vector<Eigen::Vector3d> & positions, std::vector<Eigen::Vector3d> & velocities) const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef _KINO_RRT_STAR_H_
+#define _KINO_RRT_STAR_H_
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <Eigen/Eigen>
+#include "backward.hpp"
+#include <hw_tool.h>
+
+// kinodynamic RRT* over position-velocity state of the double integrator.
+//
+// the closed-form fixed-final-state OBVP, Homeworktool::OptimalBVP, is both the steering function
+// and the distance metric, so every tree edge is the optimal cubic between its two states and the
+// returned trajectory is dynamically feasible as is.
+class KinoRRTstar
+{
+	private:
+		struct KinoNode
+		{
+			Eigen::Vector3d pos, vel;
+			double cost;                  // cost-to-come from the root
+			double duration;              // duration of the OBVP edge from the parent
+			int parent;
+			std::vector<int> children;
+
+			KinoNode(const Eigen::Vector3d & _pos, const Eigen::Vector3d & _vel) :
+				pos(_pos), vel(_vel), cost(0.0), duration(0.0), parent(-1) {}
+		};
+
+		Homeworktool * homework_tool;
+
+		Eigen::Vector3d lower, upper;
+		double resolution;
+
+		double max_vel;
+		double gamma;
+		double goal_bias;
+
+		std::vector<KinoNode> nodes;
+		std::mt19937 generator;
+
+		// best connection to the goal state found so far
+		KinoNode goal_node;
+		double goal_edge_cost;
+
+		double getSearchRadius() const;
+		bool   isReachable(const KinoNode & from, const Eigen::Vector3d & pos, const Eigen::Vector3d & vel, const double radius) const;
+		bool   isEdgeFeasible(const Eigen::Vector3d & p0, const Eigen::Vector3d & v0, const Eigen::Vector3d & p1, const Eigen::Vector3d & v1, const double T) const;
+
+		void   reparent(const int node_id, const int parent_id, const double edge_cost, const double duration);
+
+	public:
+		KinoRRTstar(Homeworktool * _homework_tool, double _resolution, Eigen::Vector3d global_xyz_l, Eigen::Vector3d global_xyz_u);
+		~KinoRRTstar(){};
+
+		// [_max_vel] bounds every velocity component along the trajectory, [_gamma] scales the cost radius
+		// used for choosing parents and rewiring, [_goal_bias] is the probability of sampling the goal state
+		void setParam(double _max_vel, double _gamma, double _goal_bias);
+
+		// grow the tree for at most [max_iterations] samples or [time_budget] seconds. true if the goal is reached
+		bool plan(
+			const Eigen::Vector3d & start_pos, const Eigen::Vector3d & start_vel,
+			const Eigen::Vector3d & target_pos, const Eigen::Vector3d & target_vel,
+			const int max_iterations, const double time_budget
+		);
+
+		double getCost() const;
+		int    getTreeSize() const { return nodes.size(); }
+
+		// sample the best trajectory every [delta_time] seconds
+		void getTrajectory(const double delta_time, std::vector<Eigen::Vector3d> & positions, std::vector<Eigen::Vector3d> & velocities) const;
+
+		// state at time t along the optimal OBVP edge of duration T between two states
+		static void evaluateEdge(
+			const Eigen::Vector3d & p0, const Eigen::Vector3d & v0, const Eigen::Vector3d & p1, const Eigen::Vector3d & v1,
+			const double T, const double t, Eigen::Vector3d & pos, Eigen::Vector3d & vel
+		);
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef _OBVP_SOLVER_H_
+#define _OBVP_SOLVER_H_
+
+#include <Eigen/Eigen>
+#include <obvp_closed_form.hpp>
+
+// time-optimal OBVP of the double integrator with fixed final state, cost J = T + integral of |a|^2.
+//
+// with a = |v0|^2 + v0.v1 + |v1|^2, b = dp.(v0 + v1), c = |dp|^2 the cost of the optimal cubic is
+//
+//     J(T) = T + 4 a / T - 12 b / T^2 + 12 c / T^3
+//
+// and dJ/dT = 0 reduces to the depressed quartic T^4 - 4 a T^2 + 24 b T - 36 c = 0, the two zero roots
+// of the usual sextic being factored out. it is solved in closed form by obvp_closed_form.hpp, shared
+// with the capstone. nothing allocates or logs, so it is safe in inner loops.
+class OBVPSolver
+{
+	public:
+		// number of coefficient triplets per batch when they have to be staged on the stack
+		static const int BatchSize = 64;
+
+		static inline void getCoefficients(
+			const Eigen::Vector3d & delta_position, const Eigen::Vector3d & start_velocity, const Eigen::Vector3d & target_velocity,
+			double & a, double & b, double & c
+		) {
+			a = start_velocity.squaredNorm() + start_velocity.dot(target_velocity) + target_velocity.squaredNorm();
+			b = delta_position.dot(start_velocity + target_velocity);
+			c = delta_position.squaredNorm();
+		}
+
+		static inline double evaluateCost(const double a, const double b, const double c, const double T) {
+			return obvp_closed_form::EvaluateCost(a, b, c, T);
+		}
+
+		// real roots of x^4 + p x^2 + q x + r, returns their number
+		static int solveDepressedQuartic(const double p, const double q, const double r, double roots[4]);
+
+		// minimum cost over the positive stationary durations, infinity if there is none
+		static double solve(const double a, const double b, const double c, double & optimal_time);
+
+		static double solve(
+			const Eigen::Vector3d & start_position, const Eigen::Vector3d & start_velocity,
+			const Eigen::Vector3d & target_position, const Eigen::Vector3d & target_velocity,
+			double & optimal_time
+		);
+
+		// [num] problems given by their coefficient arrays. [optimal_time] may be NULL
+		static void solve(const int num, const double * a, const double * b, const double * c, double * cost, double * optimal_time);
+
+		// state at time t along the optimal cubic of duration T between two states
+		static void evaluate(
+			const Eigen::Vector3d & p0, const Eigen::Vector3d & v0, const Eigen::Vector3d & p1, const Eigen::Vector3d & v1,
+			const double T, const double t, Eigen::Vector3d & pos, Eigen::Vector3d & vel
+		);
+
+		// accelerations at both ends of the optimal cubic, the acceleration is linear in between
+		static void getBoundaryAccelerations(
+			const Eigen::Vector3d & p0, const Eigen::Vector3d & v0, const Eigen::Vector3d & p1, const Eigen::Vector3d & v1,
+			const double T, Eigen::Vector3d & start_acc, Eigen::Vector3d & end_acc
+		);
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef _PRIMITIVE_SCORER_H_
+#define _PRIMITIVE_SCORER_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <Eigen/Eigen>
+#include "backward.hpp"
+#include <hw_tool.h>
+#include <trajectory_library.h>
+
+// scoring of the lattice primitives as a weighted sum of cost terms, and selection of the best ones.
+//
+// a cost term is a kernel that fills the costs of a contiguous range of primitives from the rows of
+// the library, so it vectorises across primitives like the rollout does. the built-in terms are the
+// OBVP cost from the end state to the target, the clearance to the occupied voxels along the primitive
+// and the control effort. evaluation of disjoint ranges may run concurrently.
+class PrimitiveScorer
+{
+	public:
+		// everything a kernel may read, set by prepare
+		struct Context
+		{
+			const TrajectoryLibrary * library;
+			const Homeworktool      * homework_tool;
+			Eigen::Vector3d target_pt;
+			double duration;
+
+			Eigen::Vector3d map_lower;
+			double resolution;
+
+			// voxel offsets within the clearance radius sorted by distance, the distance in the last entry
+			std::vector<Eigen::Vector4i> neighbourhood;
+			int clearance_radius;
+		};
+
+		// fill cost[0, end - begin) for the primitives in [begin, end), at most BatchSize of them
+		typedef void (*CostKernel)(const Context & context, const int begin, const int end, double * cost);
+
+		static const int BatchSize = 64;
+
+		// OBVP cost from the end state to the target, the final velocity is the end velocity
+		static void obvpCost(const Context & context, const int begin, const int end, double * cost);
+		// sum over the samples of (1 - d / R)^2 for the nearest occupied voxel at d < R voxels
+		static void clearanceCost(const Context & context, const int begin, const int end, double * cost);
+		// integral of |a|^2 over the primitive
+		static void controlEffort(const Context & context, const int begin, const int end, double * cost);
+
+	private:
+		struct Term
+		{
+			std::string name;
+			CostKernel  kernel;
+			double      weight;
+		};
+
+		std::vector<Term> terms;
+		Context context;
+
+	public:
+		PrimitiveScorer(double _resolution, Eigen::Vector3d global_xyz_l);
+		~PrimitiveScorer(){};
+
+		// terms with a zero weight are left out
+		void addTerm(const std::string & name, CostKernel kernel, const double weight);
+		void clearTerms() { terms.clear(); }
+		int  getNumTerms() const { return terms.size(); }
+
+		void setClearanceRadius(const int radius);
+
+		void prepare(const TrajectoryLibrary & library, const Homeworktool * homework_tool, const Eigen::Vector3d & target_pt, const double duration);
+
+		// weighted cost of the primitives in [begin, end) into library.cost()
+		void evaluate(TrajectoryLibrary & library, const int begin, const int end) const;
+
+		// up to [k] collision free primitives in ascending cost, ties to the lower index, returns their number
+		int selectBest(const TrajectoryLibrary & library, const int k, std::vector<int> & best) const;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef _PRIMITIVE_TABLE_H_
+#define _PRIMITIVE_TABLE_H_
+
+#include <iostream>
+#include <string>
+#include <stdint.h>
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <Eigen/Eigen>
+#include "backward.hpp"
+#include <trajectory_library.h>
+
+// offline tables of the lattice primitives, one cell per quantised start velocity.
+//
+// for a fixed acceleration lattice a primitive only depends on the start velocity up to a translation,
+// so every cell stores the displacements from the start point of all primitives and the voxels they
+// may sweep, as offsets from the start voxel. a start velocity is snapped to its nearest cell and the
+// residual velocity is added to the displacements on lookup. the offsets cover any start point inside
+// the start voxel and any start velocity within half a cell, so they are a conservative superset of the
+// voxels hit by the samples. the file is memory-mapped and only the pages of the cells that are used are
+// ever read, all sections are checked against the size of the file when it is loaded.
+//
+// file layout, every section starts on a 64 byte boundary:
+//
+//     Header
+//     double   accelerations[3][num_primitives]
+//     float    displacements[num_cells][3][num_samples][num_primitives]
+//     uint32_t voxel_begin[num_cells * num_primitives + 1]
+//     int16_t  voxels[voxel_begin[num_cells * num_primitives]][3]
+class PrimitiveTable
+{
+	private:
+		struct Header
+		{
+			char     magic[8];
+			uint32_t version;
+			int32_t  num_primitives, num_samples;
+			int32_t  vel_count[3];
+			double   delta_time, resolution;
+			double   vel_lower[3], vel_resolution;
+			uint64_t accelerations_offset, displacements_offset, voxel_begin_offset, voxels_offset;
+			uint64_t file_size;
+		};
+
+		void   * mapping;
+		size_t   mapping_size;
+
+		const Header   * header;
+		const double   * accelerations;
+		const float    * displacements;
+		const uint32_t * voxel_begin;
+		const int16_t  * voxels;
+
+		PrimitiveTable(const PrimitiveTable &);
+		PrimitiveTable & operator=(const PrimitiveTable &);
+
+	public:
+		PrimitiveTable();
+		~PrimitiveTable();
+
+		// tabulate the accelerations of [lattice] for the start velocities vel_lower + i * vel_resolution,
+		// i in [0, vel_count) per axis, and write the table to [path]
+		static bool generate(
+			const std::string & path, const TrajectoryLibrary & lattice, const double delta_time, const double resolution,
+			const Eigen::Vector3d & vel_lower, const double vel_resolution, const Eigen::Vector3i & vel_count
+		);
+
+		bool load(const std::string & path);
+		void unload();
+		bool isLoaded() const { return header != NULL; }
+
+		// cell of the tabulated start velocity nearest to [velocity], -1 if it is more than half a cell outside the table
+		int findCell(const Eigen::Vector3d & velocity) const;
+
+		// true if the table was generated for the primitives, samples and resolution of this query
+		bool isCompatible(const TrajectoryLibrary & library, const double delta_time, const double resolution) const;
+
+		// fill the positions and velocities of [library] from [start_pt] & [start_velocity] with the primitives of [cell],
+		// corrected by the offset of [start_velocity] from the velocity of the cell
+		void lookup(const int cell, const Eigen::Vector3d & start_pt, const Eigen::Vector3d & start_velocity, const double delta_time, TrajectoryLibrary & library) const;
+
+		// voxel offsets from the start voxel that [primitive] of [cell] may sweep, returns their number
+		int getSweptVoxels(const int cell, const int primitive, const int16_t * & offsets) const {
+			const uint32_t * begin = voxel_begin + size_t(cell) * header->num_primitives + primitive;
+			offsets = voxels + 3 * size_t(begin[0]);
+			return begin[1] - begin[0];
+		}
+};
+
+#endif
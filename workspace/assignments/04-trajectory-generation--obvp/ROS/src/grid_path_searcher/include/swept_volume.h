@@ -0,0 +1,75 @@
+#ifndef _SWEPT_VOLUME_H_
+#define _SWEPT_VOLUME_H_
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <Eigen/Eigen>
+#include "backward.hpp"
+#include <hw_tool.h>
+#include <trajectory_library.h>
+
+// exact voxels swept by the constant-acceleration primitives of a TrajectoryLibrary.
+//
+// along every axis the position is a parabola in t, monotone on at most two pieces, so the times at
+// which it crosses voxel boundaries follow from a quadratic. walking the crossings of the three axes in
+// time order visits every voxel the primitive passes through, however fast it moves. the pattern of a
+// primitive only depends on the start point within its voxel, the start velocity and the duration, so
+// the offsets from the start voxel are cached per primitive and reused until one of them changes.
+// the outcome of the collision check is cached as well while the start voxel stays the same, newly
+// occupied voxels only flip the primitives that sweep them.
+class SweptVolume
+{
+	private:
+		struct Crossing
+		{
+			double time;
+			int    axis, step;
+			bool operator<(const Crossing & other) const { return time < other.time; }
+		};
+
+		struct Pattern
+		{
+			bool valid;
+			std::vector<int16_t>  offsets;     // x, y, z from the start voxel, in the order they are entered
+			std::vector<Crossing> crossings;   // scratch
+			Eigen::Vector3i box_min, box_max;  // bounds of the offsets
+
+			bool checked, free;                // outcome of the last collision check
+		};
+
+		Eigen::Vector3d lower;
+		double resolution;
+
+		// key of the cached patterns
+		Eigen::Vector3d start_offset, start_velocity;
+		double duration;
+		std::vector<double> accelerations;
+
+		Eigen::Vector3i start_index;
+		std::vector<Pattern> patterns;
+
+		void sweep(const Eigen::Vector3d & acceleration, Pattern & pattern) const;
+
+	public:
+		SweptVolume(double _resolution, Eigen::Vector3d global_xyz_l);
+		~SweptVolume(){};
+
+		// set up the primitives of [library] rolled out from the start state for [_duration] seconds.
+		// the cached patterns are dropped only if the sub-voxel start, velocity, duration or inputs changed
+		void prepare(const TrajectoryLibrary & library, const Eigen::Vector3d & start_pt, const Eigen::Vector3d & _start_velocity, const double _duration);
+
+		// true if no voxel swept by [primitive] is occupied, stops at the first occupied one. calls for
+		// different primitives may run concurrently
+		bool isPrimitiveFree(const int primitive, const TrajectoryLibrary & library, const Homeworktool & homework_tool);
+
+		// [voxels] became occupied since the last check, obstacles are never cleared
+		void addObstacles(const std::vector<Eigen::Vector3i> & voxels);
+
+		// swept voxels of [primitive] as offsets from the start voxel, the start voxel itself excluded
+		const std::vector<int16_t> & getOffsets(const int primitive, const TrajectoryLibrary & library);
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads for data-parallel loops. the calling thread takes part in the work,
+// so a pool of size 1 runs everything inline without any synchronisation.
+class ThreadPool
+{
+	private:
+		std::vector<std::thread> workers;
+
+		std::mutex pool_mutex;
+		std::condition_variable work_ready, work_done;
+
+		// current job, guarded by mutex:
+		const std::function<void(int)> * job;
+		int  num_tasks, next_task, num_finished;
+		long generation;
+		bool stopping;
+
+		void workerLoop();
+		// run tasks of the current job until none is left, returns the number of tasks run
+		int  runTasks(std::unique_lock<std::mutex> & lock);
+
+		ThreadPool(const ThreadPool &);
+		ThreadPool & operator=(const ThreadPool &);
+
+	public:
+		// [num_threads] including the calling thread, 0 picks the hardware concurrency
+		explicit ThreadPool(int num_threads = 0);
+		~ThreadPool();
+
+		int getNumThreads() const { return workers.size() + 1; }
+
+		// call task(i) for every i in [0, _num_tasks) and block until all of them are done
+		void parallelFor(const int _num_tasks, const std::function<void(int)> & task);
+};
+
+#endif
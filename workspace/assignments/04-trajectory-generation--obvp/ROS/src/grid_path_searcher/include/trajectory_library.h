@@ -0,0 +1,95 @@
+#ifndef _TRAJECTORY_LIBRARY_H_
+#define _TRAJECTORY_LIBRARY_H_
+
+#include <iostream>
+#include <stdint.h>
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <Eigen/Eigen>
+#include "backward.hpp"
+
+// motion primitives of the lattice planner, stored in a single arena which is kept across queries.
+//
+// every quantity is a structure-of-arrays row over the primitives, rows are padded to a multiple of
+// Alignment / sizeof(double) entries and start on an Alignment boundary:
+//
+//     double  position[3][num_samples][stride]
+//     double  velocity[3][num_samples][stride]
+//     double  acceleration[3][stride]
+//     double  cost[stride]
+//     uint8_t collision[stride]                  1 if the primitive hits an obstacle
+//
+// the arena only grows, so once the largest lattice has been seen building a library allocates nothing.
+class TrajectoryLibrary
+{
+	private:
+		static const size_t Alignment = 64;
+
+		void   * arena;
+		size_t   capacity;
+
+		int num_primitives, num_samples, stride;
+		int optimal;
+
+		double  * positions;
+		double  * velocities;
+		double  * accelerations;
+		double  * costs;
+		uint8_t * collisions;
+
+		TrajectoryLibrary(const TrajectoryLibrary &);
+		TrajectoryLibrary & operator=(const TrajectoryLibrary &);
+
+	public:
+		TrajectoryLibrary();
+		~TrajectoryLibrary();
+
+		// lay out the arena for [_num_primitives] primitives of [_num_samples] states each. the contents are
+		// undefined afterwards, except for the padding accelerations which are zero
+		bool resize(const int _num_primitives, const int _num_samples);
+
+		int getNumPrimitives() const { return num_primitives; }
+		int getNumSamples()    const { return num_samples; }
+		int getStride()        const { return stride; }
+		size_t getCapacity()   const { return capacity; }
+
+		// rows over all primitives:
+		double * position(const int axis, const int sample) { return positions  + (size_t(axis) * num_samples + sample) * stride; }
+		double * velocity(const int axis, const int sample) { return velocities + (size_t(axis) * num_samples + sample) * stride; }
+		double * acceleration(const int axis)               { return accelerations + size_t(axis) * stride; }
+		double  * cost()      { return costs; }
+		uint8_t * collision() { return collisions; }
+
+		const double * position(const int axis, const int sample) const { return positions  + (size_t(axis) * num_samples + sample) * stride; }
+		const double * velocity(const int axis, const int sample) const { return velocities + (size_t(axis) * num_samples + sample) * stride; }
+		const double * acceleration(const int axis)               const { return accelerations + size_t(axis) * stride; }
+		const double  * cost()      const { return costs; }
+		const uint8_t * collision() const { return collisions; }
+
+		// single primitive access:
+		Eigen::Vector3d getPosition(const int primitive, const int sample) const {
+			return Eigen::Vector3d(position(0, sample)[primitive], position(1, sample)[primitive], position(2, sample)[primitive]);
+		}
+		Eigen::Vector3d getVelocity(const int primitive, const int sample) const {
+			return Eigen::Vector3d(velocity(0, sample)[primitive], velocity(1, sample)[primitive], velocity(2, sample)[primitive]);
+		}
+		Eigen::Vector3d getAcceleration(const int primitive) const {
+			return Eigen::Vector3d(acceleration(0)[primitive], acceleration(1)[primitive], acceleration(2)[primitive]);
+		}
+		void setState(const int primitive, const int sample, const Eigen::Vector3d & pos, const Eigen::Vector3d & vel) {
+			for(int axis = 0; axis < 3; axis++) {
+				position(axis, sample)[primitive] = pos(axis);
+				velocity(axis, sample)[primitive] = vel(axis);
+			}
+		}
+
+		// constant-acceleration rollout of all primitives from a common start state in closed form,
+		// p(t) = p0 + v0 * t + a * t^2 / 2 at t = sample * delta_time. the accelerations must be set
+		void rollout(const Eigen::Vector3d & start_pt, const Eigen::Vector3d & start_velocity, const double delta_time);
+
+		// index of the selected primitive, -1 if none is collision free
+		void setOptimal(const int primitive) { optimal = primitive; }
+		int  getOptimal() const { return optimal; }
+};
+
+#endif
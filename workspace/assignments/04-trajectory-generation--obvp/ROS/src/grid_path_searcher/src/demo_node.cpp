@@ -1,6 +1,9 @@
 #include <iostream>
 #include <fstream>
 #include <math.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <pcl_conversions/pcl_conversions.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
@@ -15,6 +18,13 @@
 #include <visualization_msgs/Marker.h>
 
 #include <hw_tool.h>
+#include <kino_rrt_star.h>
+#include <kino_astar.h>
+#include <primitive_table.h>
+#include <swept_volume.h>
+#include <primitive_scorer.h>
+#include <trajectory_library.h>
+#include <thread_pool.h>
 #include "backward.hpp"
 
 using namespace std;
@@ -36,8 +46,17 @@ Vector3d _map_lower, _map_upper;
 int _max_x_id, _max_y_id, _max_z_id;
 
 // ros related
-ros::Subscriber _map_sub, _pts_sub;
+ros::Subscriber _map_sub, _pts_sub, _odom_sub;
 ros::Publisher  _grid_map_vis_pub, _path_vis_pub;
+ros::Timer      _receding_timer;
+
+// receding-horizon lattice planning from the odometry state
+bool     _receding_horizon;
+double   _receding_rate, _receding_hysteresis, _receding_time_budget;
+bool     _has_odom   = false;
+bool     _has_target = false;
+Vector3d _odom_pt, _odom_velocity, _target_pt;
+int      _receding_best = -1;
 
 // Integral parameter
 double _max_input_acc     = 1.0;
@@ -45,13 +64,60 @@ int    _discretize_step   = 2;
 double _time_interval     = 1.25;
 int    _time_step         = 50;
 
+// kinodynamic RRT* parameter
+std::string _planning_method;
+double _kino_max_vel, _kino_gamma, _kino_goal_bias, _kino_time_budget;
+int    _kino_max_iterations;
+
+// hybrid-state A* parameter
+double _astar_max_vel, _astar_max_acc, _astar_primitive_time, _astar_vel_resolution, _astar_heuristic_weight;
+int    _astar_discretize_step, _astar_max_expansions;
+
 Homeworktool * _homework_tool     = new Homeworktool();
-TrajectoryStatePtr *** TraLibrary;
+KinoRRTstar  * _kino_rrt_star     = NULL;
+KinoAstar    * _kino_astar        = NULL;
+TrajectoryLibrary _tra_library;
+
+// offline primitive table, used when it holds the lattice and start velocity of the query
+std::string    _primitive_table_path;
+PrimitiveTable _primitive_table;
+int            _table_cell = -1;
+Vector3i       _table_start_index;
+
+// exact swept voxels of the online primitives, cached while the start state stays the same
+SweptVolume  * _swept_volume = NULL;
+
+// lattice evaluation is split into contiguous chunks of primitives
+int          _num_threads;
+ThreadPool * _thread_pool = NULL;
+
+// weighted cost terms of the primitives, and the best collision free ones of the last query
+PrimitiveScorer * _scorer = NULL;
+double _obvp_weight, _clearance_weight, _effort_weight;
+int    _clearance_radius, _num_candidates;
+vector<int> _candidates;
+
+// trajectory library visualisation, built on the planning thread and published from its own thread
+bool   _vis_tra_library;
+int    _vis_decimation;
+std::thread             _vis_thread;
+std::mutex              _vis_mutex;
+std::condition_variable _vis_ready;
+visualization_msgs::MarkerArray _vis_pending;
+bool   _vis_has_pending = false;
+bool   _vis_stopping    = false;
 
 void rcvWaypointsCallback(const nav_msgs::Path & wp);
 void rcvPointCloudCallBack(const sensor_msgs::PointCloud2 & pointcloud_map);
-void trajectoryLibrary(const Eigen::Vector3d start_pt, const Eigen::Vector3d start_velocity, const Eigen::Vector3d target_pt);
-void visTraLibrary(TrajectoryStatePtr *** TraLibrary);
+void rcvOdometryCallback(const nav_msgs::Odometry & odom);
+void recedingHorizonCallback(const ros::TimerEvent & event);
+void trajectoryLibrary(const Eigen::Vector3d start_pt, const Eigen::Vector3d start_velocity, const Eigen::Vector3d target_pt, const int warm_candidate = -1);
+void evaluatePrimitives(const int begin, const int end);
+void visTraLibrary(const TrajectoryLibrary & TraLibrary);
+void visPublisherLoop();
+void kinodynamicPathFinding(const Eigen::Vector3d start_pt, const Eigen::Vector3d start_velocity, const Eigen::Vector3d target_pt);
+void hybridAstarPathFinding(const Eigen::Vector3d start_pt, const Eigen::Vector3d start_velocity, const Eigen::Vector3d target_pt);
+void visKinoTrajectory(const vector<Vector3d> & positions);
 
 void rcvWaypointsCallback(const nav_msgs::Path & wp)
 {     
@@ -64,12 +130,24 @@ void rcvWaypointsCallback(const nav_msgs::Path & wp)
                  wp.poses[0].pose.position.z;
 
     ROS_INFO("[node] receive the planning target");
-    trajectoryLibrary(_start_pt,_start_velocity,target_pt);
+    if( _receding_horizon ){
+        // planned from the odometry on every tick
+        _target_pt      = target_pt;
+        _has_target     = true;
+        _receding_best  = -1;
+    }
+    else if( _kino_rrt_star != NULL )
+        kinodynamicPathFinding(_start_pt,_start_velocity,target_pt);
+    else if( _kino_astar != NULL )
+        hybridAstarPathFinding(_start_pt,_start_velocity,target_pt);
+    else
+        trajectoryLibrary(_start_pt,_start_velocity,target_pt);
 }
 
 void rcvPointCloudCallBack(const sensor_msgs::PointCloud2 & pointcloud_map)
 {   
-    if(_has_map ) return;
+    // only the receding-horizon mode follows map updates, obstacles are added but never cleared
+    if(_has_map && !_receding_horizon) return;
 
     pcl::PointCloud<pcl::PointXYZ> cloud;
     pcl::PointCloud<pcl::PointXYZ> cloud_vis;
@@ -79,13 +157,16 @@ void rcvPointCloudCallBack(const sensor_msgs::PointCloud2 & pointcloud_map)
     
     if( (int)cloud.points.size() == 0 ) return;
 
+    vector<Vector3i> new_obstacles;
+
     pcl::PointXYZ pt;
     for (int idx = 0; idx < (int)cloud.points.size(); idx++)
     {    
         pt = cloud.points[idx];        
 
         // set obstalces into grid map for path planning
-        _homework_tool->setObs(pt.x, pt.y, pt.z);
+        if( _homework_tool->setObs(pt.x, pt.y, pt.z) && _has_map )
+            new_obstacles.push_back(_homework_tool->coord2gridIndex(Vector3d(pt.x, pt.y, pt.z)));
 
         // for visualize only
         Vector3d cor_round = _homework_tool->coordRounding(Vector3d(pt.x, pt.y, pt.z));
@@ -104,90 +185,175 @@ void rcvPointCloudCallBack(const sensor_msgs::PointCloud2 & pointcloud_map)
     map_vis.header.frame_id = "/world";
     _grid_map_vis_pub.publish(map_vis);
 
+    // cached collision checks of the primitives that sweep a new obstacle are flipped
+    if( !new_obstacles.empty() )
+        _swept_volume->addObstacles(new_obstacles);
+
     _has_map = true;
 }
 
-void trajectoryLibrary(const Vector3d start_pt, const Vector3d start_velocity, const Vector3d target_pt)
+void rcvOdometryCallback(const nav_msgs::Odometry & odom)
 {
-    Vector3d acc_input;
-    Vector3d pos,vel;
-    int a =0 ;
-    int b =0 ;
-    int c =0 ;
+    _odom_pt << odom.pose.pose.position.x,
+                odom.pose.pose.position.y,
+                odom.pose.pose.position.z;
 
-    double min_Cost = 100000.0;
-    double Trajctory_Cost;
-    TraLibrary  = new TrajectoryStatePtr ** [_discretize_step + 1];     //recored all trajectories after input
+    _odom_velocity << odom.twist.twist.linear.x,
+                      odom.twist.twist.linear.y,
+                      odom.twist.twist.linear.z;
 
+    _has_odom = true;
+}
+
+// evaluate the lattice from the current state, the best primitive of the last tick is the warm candidate
+void recedingHorizonCallback(const ros::TimerEvent & event)
+{
+    if( !_has_map || !_has_odom || !_has_target )
+        return;
+
+    if( (_odom_pt - _target_pt).norm() < _resolution ){
+        ROS_INFO("[node] receding horizon reached the target");
+        _has_target    = false;
+        _receding_best = -1;
+        return;
+    }
+
+    ros::WallTime time_1 = ros::WallTime::now();
+    trajectoryLibrary(_odom_pt, _odom_velocity, _target_pt, _receding_best);
+    ros::WallTime time_2 = ros::WallTime::now();
+
+    _receding_best = _tra_library.getOptimal();
+
+    const double latency = (time_2 - time_1).toSec();
+    if( latency > _receding_time_budget )
+        ROS_WARN("[node] receding horizon tick took %f ms, budget %f ms", latency * 1000.0, _receding_time_budget * 1000.0);
+    if( _receding_best < 0 )
+        ROS_WARN("[node] receding horizon found no collision free primitive");
+}
+
+void trajectoryLibrary(const Vector3d start_pt, const Vector3d start_velocity, const Vector3d target_pt, const int warm_candidate)
+{
+    //recored all trajectories after input, the start state plus _time_step + 1 integration steps per primitive
+    const int num_inputs = _discretize_step + 1;
+    if( !_tra_library.resize(num_inputs * num_inputs * num_inputs, _time_step + 2) )
+        return;
+
+    const double acc_step = 2 * _max_input_acc / double(_discretize_step);
     for(int i=0; i <= _discretize_step; i++){           //acc_input_ax
-        TraLibrary[i] = new TrajectoryStatePtr * [_discretize_step + 1];
         for(int j=0;j <= _discretize_step; j++){        //acc_input_ay
-            TraLibrary[i][j] = new TrajectoryStatePtr [_discretize_step + 1];
             for(int k=0; k <= _discretize_step; k++){   //acc_input_az
-                vector<Vector3d> Position;
-                vector<Vector3d> Velocity;
-
-                acc_input(0) = double(-_max_input_acc + i * (2 * _max_input_acc / double(_discretize_step)) );
-                acc_input(1) = double(-_max_input_acc + j * (2 * _max_input_acc / double(_discretize_step)) );
-                acc_input(2) = double( k * (2 * _max_input_acc / double(_discretize_step) ) + 0.1);                          //acc_input_az >0.1
-                
-                pos(0) = start_pt(0);
-                pos(1) = start_pt(1);
-                pos(2) = start_pt(2);
-                vel(0) = start_velocity(0);
-                vel(1) = start_velocity(1);
-                vel(2) = start_velocity(2);
-
-                Position.push_back(pos);
-                Velocity.push_back(vel);
-
-                bool collision = false;
-                double delta_time;
-                delta_time = _time_interval / double(_time_step);
-                
-                for(int step=0 ; step<=_time_step ; step ++){
-                    /*
-                        STEP 1: implement forward integration with the modelling has been given in the document
-                                use the pos and vel to recored the steps in the trajectory
-                    */
-                    pos += delta_time*(vel + 0.5*delta_time*acc_input);
-                    vel += delta_time*acc_input;
-                    
-                    Position.push_back(pos);
-                    Velocity.push_back(vel);
-
-                    // check if if the trajectory face the obstacle
-                    if(_homework_tool->isObsFree(pos.x(),pos.y(),pos.z()) != 1){
-                        collision = true;
-                    }
-                }
-                /*
-                    STEP 2: get 
-                */
-                Trajctory_Cost = _homework_tool -> OptimalBVP(pos,vel,target_pt);
-
-                //input the trajetory in the trajectory library
-                TraLibrary[i][j][k] = new TrajectoryState(Position,Velocity,Trajctory_Cost);
-                
-                //if there is not any obstacle in the trajectory we need to set 'collision_check = true', so this trajectory is useable
-                if(collision)
-                    TraLibrary[i][j][k]->setCollisionfree();
-                
-                //record the min_cost in the trajectory Library, and this is the part pf selecting the best trajectory cloest to the planning traget
-                if(Trajctory_Cost<min_Cost && TraLibrary[i][j][k]->collision_check == false){
-                    a = i;
-                    b = j;
-                    c = k;
-                    min_Cost = Trajctory_Cost;
-                }
+                const int primitive = (i * num_inputs + j) * num_inputs + k;
+
+                _tra_library.acceleration(0)[primitive] = -_max_input_acc + i * acc_step;
+                _tra_library.acceleration(1)[primitive] = -_max_input_acc + j * acc_step;
+                _tra_library.acceleration(2)[primitive] = k * acc_step + 0.1;                    //acc_input_az >0.1
             }
         }
     }
-    TraLibrary[a][b][c] -> setOptimal();
-    visTraLibrary(TraLibrary);
+
+    /*
+        STEP 1: forward integration of all primitives at once, constant input so the closed form is exact.
+        a tabulated start velocity only needs the primitives of its cell translated to the start point
+    */
+    const double delta_time = _time_interval / double(_time_step);
+    _table_cell = _primitive_table.isCompatible(_tra_library, delta_time, _resolution) ? _primitive_table.findCell(start_velocity) : -1;
+    if( _table_cell >= 0 ){
+        _primitive_table.lookup(_table_cell, start_pt, start_velocity, delta_time, _tra_library);
+        _table_start_index = _homework_tool->coord2gridIndex(start_pt);
+    }
+    else{
+        _tra_library.rollout(start_pt, start_velocity, delta_time);
+        _swept_volume->prepare(_tra_library, start_pt, start_velocity, (_tra_library.getNumSamples() - 1) * delta_time);
+    }
+
+    _scorer->prepare(_tra_library, _homework_tool, target_pt, (_tra_library.getNumSamples() - 1) * delta_time);
+
+    const int num_primitives = _tra_library.getNumPrimitives();
+    const int num_chunks     = min(num_primitives, 4 * _thread_pool->getNumThreads());
+
+    _thread_pool->parallelFor(num_chunks, [num_primitives, num_chunks](int chunk){
+        const int begin = int(int64_t(chunk)     * num_primitives / num_chunks);
+        const int end   = int(int64_t(chunk + 1) * num_primitives / num_chunks);
+
+        evaluatePrimitives(begin, end);
+    });
+
+    //record the min_cost in the trajectory Library, and this is the part pf selecting the best trajectory cloest to the planning traget.
+    //the best _num_candidates are kept as fallbacks, ties go to the first primitive as in a serial scan
+    _scorer->selectBest(_tra_library, _num_candidates, _candidates);
+    int best = _candidates.empty() ? -1 : _candidates[0];
+
+    //the warm candidate is kept unless the best one is better by more than the hysteresis, so the choice does not chatter
+    if( best >= 0 && warm_candidate >= 0 && warm_candidate < num_primitives && !_tra_library.collision()[warm_candidate] ){
+        if( _tra_library.cost()[warm_candidate] <= _tra_library.cost()[best] * (1.0 + _receding_hysteresis) )
+            best = warm_candidate;
+    }
+    _tra_library.setOptimal(best);
+    if( _vis_tra_library )
+        visTraLibrary(_tra_library);
     return;
 }
 
+// collision check and cost of the rolled out primitives in [begin, end)
+void evaluatePrimitives(const int begin, const int end)
+{
+    for(int primitive = begin; primitive < end; primitive++){
+        if( _table_cell >= 0 ){
+            // voxels the primitive may sweep, stop at the first occupied one
+            const int16_t * offsets;
+            const int num_voxels = _primitive_table.getSweptVoxels(_table_cell, primitive, offsets);
+
+            bool collision = false;
+            for(int voxel = 0; voxel < num_voxels && !collision; voxel++){
+                const Vector3i index = _table_start_index + Vector3i(offsets[3 * voxel], offsets[3 * voxel + 1], offsets[3 * voxel + 2]);
+                collision = !_homework_tool->isObsFree(index);
+            }
+            _tra_library.collision()[primitive] = collision;
+            continue;
+        }
+
+        // check if if the trajectory face the obstacle, anywhere between the samples too
+        _tra_library.collision()[primitive] = !_swept_volume->isPrimitiveFree(primitive, _tra_library, *_homework_tool);
+    }
+
+    /*
+        STEP 2: get the cost in batches, the OBVP term takes the final velocity to be the end velocity as in Homeworktool::OptimalBVP
+    */
+    _scorer->evaluate(_tra_library, begin, end);
+}
+
+void kinodynamicPathFinding(const Vector3d start_pt, const Vector3d start_velocity, const Vector3d target_pt)
+{
+    ros::Time time_1 = ros::Time::now();
+    // come to a stop at the target:
+    bool solved = _kino_rrt_star->plan(start_pt, start_velocity, target_pt, Vector3d::Zero(), _kino_max_iterations, _kino_time_budget);
+    ros::Time time_2 = ros::Time::now();
+
+    ROS_INFO("[node] kinodynamic RRT* %s in %f ms, %d nodes", solved ? "succeeded" : "failed", (time_2 - time_1).toSec() * 1000.0, _kino_rrt_star->getTreeSize());
+
+    if( !solved ) return;
+
+    vector<Vector3d> positions, velocities;
+    _kino_rrt_star->getTrajectory(_time_interval / double(_time_step), positions, velocities);
+    visKinoTrajectory(positions);
+}
+
+void hybridAstarPathFinding(const Vector3d start_pt, const Vector3d start_velocity, const Vector3d target_pt)
+{
+    ros::Time time_1 = ros::Time::now();
+    // come to a stop at the target:
+    bool solved = _kino_astar->plan(start_pt, start_velocity, target_pt, Vector3d::Zero());
+    ros::Time time_2 = ros::Time::now();
+
+    ROS_INFO("[node] hybrid-state A* %s in %f ms, %d states", solved ? "succeeded" : "failed", (time_2 - time_1).toSec() * 1000.0, _kino_astar->getNumStates());
+
+    if( !solved ) return;
+
+    vector<Vector3d> positions, velocities;
+    _kino_astar->getTrajectory(_time_interval / double(_time_step), positions, velocities);
+    visKinoTrajectory(positions);
+}
+
 int main(int argc, char** argv)
 {
     ros::init(argc, argv, "demo_node");
@@ -195,6 +361,7 @@ int main(int argc, char** argv)
 
     _map_sub  = nh.subscribe( "map",       1, rcvPointCloudCallBack );
     _pts_sub  = nh.subscribe( "waypoints", 1, rcvWaypointsCallback );
+    _odom_sub = nh.subscribe( "odom",      1, rcvOdometryCallback );
 
     _grid_map_vis_pub         = nh.advertise<sensor_msgs::PointCloud2>("grid_map_vis", 1);
     _path_vis_pub             = nh.advertise<visualization_msgs::MarkerArray>("RRTstar_path_vis",1);
@@ -213,6 +380,39 @@ int main(int argc, char** argv)
     nh.param("planning/start_vx",  _start_velocity(0),  0.0);
     nh.param("planning/start_vy",  _start_velocity(1),  0.0);
     nh.param("planning/start_vz",  _start_velocity(2),  0.0);    
+
+    nh.param("planning/discretize_step", _discretize_step,     2);
+    nh.param("planning/threads",         _num_threads,         0);
+    nh.param("planning/primitive_table", _primitive_table_path, std::string(""));
+
+    nh.param("scoring/obvp_weight",      _obvp_weight,         1.0);
+    nh.param("scoring/clearance_weight", _clearance_weight,    0.0);
+    nh.param("scoring/clearance_radius", _clearance_radius,    3);
+    nh.param("scoring/effort_weight",    _effort_weight,       0.0);
+    nh.param("scoring/num_candidates",   _num_candidates,      1);
+
+    nh.param("receding/enable",          _receding_horizon,    false);
+    nh.param("receding/rate",            _receding_rate,       50.0);
+    nh.param("receding/hysteresis",      _receding_hysteresis, 0.05);
+    nh.param("receding/time_budget",     _receding_time_budget, 0.005);
+
+    nh.param("vis/tra_library",          _vis_tra_library,     true);
+    nh.param("vis/decimation",           _vis_decimation,      5);
+
+    nh.param("planning/method",          _planning_method,     std::string("lattice"));
+    nh.param("kino/max_vel",             _kino_max_vel,        2.0);
+    nh.param("kino/gamma",               _kino_gamma,          20.0);
+    nh.param("kino/goal_bias",           _kino_goal_bias,      0.05);
+    nh.param("kino/max_iterations",      _kino_max_iterations, 5000);
+    nh.param("kino/time_budget",         _kino_time_budget,    1.0);
+
+    nh.param("astar/max_vel",            _astar_max_vel,          2.0);
+    nh.param("astar/max_acc",            _astar_max_acc,          2.0);
+    nh.param("astar/primitive_time",     _astar_primitive_time,   0.8);
+    nh.param("astar/discretize_step",    _astar_discretize_step,  2);
+    nh.param("astar/vel_resolution",     _astar_vel_resolution,   0.5);
+    nh.param("astar/heuristic_weight",   _astar_heuristic_weight, 1.5);
+    nh.param("astar/max_expansions",     _astar_max_expansions,   20000);
     
     _map_lower << - _x_size/2.0, - _y_size/2.0,     0.0;
     _map_upper << + _x_size/2.0, + _y_size/2.0, _z_size;
@@ -225,6 +425,42 @@ int main(int argc, char** argv)
 
     _homework_tool  = new Homeworktool();
     _homework_tool  -> initGridMap(_resolution, _map_lower, _map_upper, _max_x_id, _max_y_id, _max_z_id);
+    _thread_pool    = new ThreadPool(_num_threads);
+    _swept_volume   = new SweptVolume(_resolution, _map_lower);
+
+    _scorer = new PrimitiveScorer(_resolution, _map_lower);
+    _scorer -> addTerm("obvp",      PrimitiveScorer::obvpCost,      _obvp_weight);
+    _scorer -> addTerm("clearance", PrimitiveScorer::clearanceCost, _clearance_weight);
+    _scorer -> addTerm("effort",    PrimitiveScorer::controlEffort, _effort_weight);
+    _scorer -> setClearanceRadius(_clearance_radius);
+
+    if( _vis_tra_library )
+        _vis_thread = std::thread(visPublisherLoop);
+
+    if( !_primitive_table_path.empty() )
+        _primitive_table.load(_primitive_table_path);
+
+    if( _planning_method == "kino_rrt_star" )
+    {
+        _kino_rrt_star = new KinoRRTstar(_homework_tool, _resolution, _map_lower, _map_upper);
+        _kino_rrt_star -> setParam(_kino_max_vel, _kino_gamma, _kino_goal_bias);
+    }
+    else if( _planning_method == "kino_astar" )
+    {
+        _kino_astar = new KinoAstar(_homework_tool, _resolution, _map_lower, _map_upper);
+        _kino_astar -> setParam(
+            _astar_max_vel, _astar_max_acc, _astar_primitive_time, _astar_discretize_step,
+            _astar_vel_resolution, _astar_heuristic_weight, _astar_max_expansions
+        );
+    }
+
+    // the receding horizon re-evaluates the lattice, the other planners are only run on a new target
+    if( _receding_horizon && (_kino_rrt_star != NULL || _kino_astar != NULL) ){
+        ROS_WARN("[node] receding horizon needs the lattice planner, disabled for %s", _planning_method.c_str());
+        _receding_horizon = false;
+    }
+    if( _receding_horizon )
+        _receding_timer = nh.createTimer(ros::Duration(1.0 / _receding_rate), recedingHorizonCallback);
     
     ros::Rate rate(100);
     bool status = ros::ok();
@@ -235,13 +471,26 @@ int main(int argc, char** argv)
         rate.sleep();
     }
 
+    delete _kino_rrt_star;
+    delete _kino_astar;
+    if( _vis_thread.joinable() ){
+        {
+            lock_guard<mutex> lock(_vis_mutex);
+            _vis_stopping = true;
+        }
+        _vis_ready.notify_one();
+        _vis_thread.join();
+    }
+
+    delete _scorer;
+    delete _swept_volume;
+    delete _thread_pool;
     delete _homework_tool;
     return 0;
 }
 
-void visTraLibrary(TrajectoryStatePtr *** TraLibrary)
+void visTraLibrary(const TrajectoryLibrary & TraLibrary)
 {
-    double _resolution = 0.2;
     visualization_msgs::MarkerArray  LineArray;
     visualization_msgs::Marker       Line;
 
@@ -252,49 +501,96 @@ void visTraLibrary(TrajectoryStatePtr *** TraLibrary)
     Line.pose.orientation.w = 1.0;
     Line.type            = visualization_msgs::Marker::LINE_STRIP;
     Line.scale.x         = _resolution/5;
+    Line.color.a         = 1.0;
+
+    // every _vis_decimation-th sample and the last one of each primitive
+    const int decimation  = max(1, _vis_decimation);
+    const int last_sample = TraLibrary.getNumSamples() - 1;
+    const int num_points  = last_sample / decimation + 2;
+
+    LineArray.markers.reserve(TraLibrary.getNumPrimitives());
+    for(int primitive = 0; primitive < TraLibrary.getNumPrimitives(); primitive++){
+        // red in collision, green the selected one, blue otherwise
+        Line.color.r = TraLibrary.collision()[primitive] ? 1.0 : 0.0;
+        Line.color.g = (!TraLibrary.collision()[primitive] && TraLibrary.getOptimal() == primitive) ? 1.0 : 0.0;
+        Line.color.b = (!TraLibrary.collision()[primitive] && TraLibrary.getOptimal() != primitive) ? 1.0 : 0.0;
+        Line.id      = primitive;
+
+        LineArray.markers.push_back(Line);
+
+        vector<geometry_msgs::Point> & points = LineArray.markers.back().points;
+        points.reserve(num_points);
+
+        geometry_msgs::Point pt;
+        for(int index = 0; index <= last_sample; index += decimation){
+            pt.x = TraLibrary.position(0, index)[primitive];
+            pt.y = TraLibrary.position(1, index)[primitive];
+            pt.z = TraLibrary.position(2, index)[primitive];
+            points.push_back(pt);
+        }
+        if( last_sample % decimation != 0 ){
+            pt.x = TraLibrary.position(0, last_sample)[primitive];
+            pt.y = TraLibrary.position(1, last_sample)[primitive];
+            pt.z = TraLibrary.position(2, last_sample)[primitive];
+            points.push_back(pt);
+        }
+    }
+
+    // serialisation and sending happen on the visualisation thread, a newer library replaces an unsent one
+    {
+        lock_guard<mutex> lock(_vis_mutex);
+        _vis_pending.markers.swap(LineArray.markers);
+        _vis_has_pending = true;
+    }
+    _vis_ready.notify_one();
+}
+
+void visPublisherLoop()
+{
+    visualization_msgs::MarkerArray LineArray;
+
+    unique_lock<mutex> lock(_vis_mutex);
+    while( true ){
+        _vis_ready.wait(lock, []{ return _vis_stopping || _vis_has_pending; });
+        if( _vis_stopping )
+            return;
+
+        LineArray.markers.swap(_vis_pending.markers);
+        _vis_has_pending = false;
+
+        lock.unlock();
+        _path_vis_pub.publish(LineArray);
+        lock.lock();
+    }
+}
+
+void visKinoTrajectory(const vector<Vector3d> & positions)
+{
+    visualization_msgs::MarkerArray  LineArray;
+    visualization_msgs::Marker       Line;
+
+    Line.header.frame_id = "world";
+    Line.header.stamp    = ros::Time::now();
+    Line.ns              = "demo_node/KinoRRTstar";
+    Line.action          = visualization_msgs::Marker::ADD;
+    Line.pose.orientation.w = 1.0;
+    Line.type            = visualization_msgs::Marker::LINE_STRIP;
+    Line.scale.x         = _resolution/5;
+    Line.id              = 0;
 
     Line.color.r         = 0.0;
-    Line.color.g         = 0.0;
-    Line.color.b         = 1.0;
+    Line.color.g         = 1.0;
+    Line.color.b         = 0.0;
     Line.color.a         = 1.0;
 
-    int marker_id = 0;
-
-    for(int i = 0; i <= _discretize_step; i++){
-        for(int j = 0; j<= _discretize_step;j++){  
-            for(int k = 0; k<= _discretize_step;k++){
-                if(TraLibrary[i][j][k]->collision_check == false){
-                    if(TraLibrary[i][j][k]->optimal_flag == true){
-                        Line.color.r         = 0.0;
-                        Line.color.g         = 1.0;
-                        Line.color.b         = 0.0;
-                        Line.color.a         = 1.0;
-                    }else{
-                        Line.color.r         = 0.0;
-                        Line.color.g         = 0.0;
-                        Line.color.b         = 1.0;
-                        Line.color.a         = 1.0;
-                    }
-                }else{
-                    Line.color.r         = 1.0;
-                    Line.color.g         = 0.0;
-                    Line.color.b         = 0.0;
-                    Line.color.a         = 1.0;
-                }
-                   Line.points.clear();
-                    geometry_msgs::Point pt;
-                    Line.id = marker_id;
-                    for(int index = 0; index < int(TraLibrary[i][j][k]->Position.size());index++){
-                        Vector3d coord = TraLibrary[i][j][k]->Position[index];
-                        pt.x = coord(0);
-                        pt.y = coord(1);
-                        pt.z = coord(2);
-                        Line.points.push_back(pt);
-                    }
-                    LineArray.markers.push_back(Line);
-                    _path_vis_pub.publish(LineArray);
-                    ++marker_id; 
-            }
-        }
-    }    
+    geometry_msgs::Point pt;
+    for(size_t index = 0; index < positions.size(); index++){
+        pt.x = positions[index](0);
+        pt.y = positions[index](1);
+        pt.z = positions[index](2);
+        Line.points.push_back(pt);
+    }
+    LineArray.markers.push_back(Line);
+
+    _path_vis_pub.publish(LineArray);
 }
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include <kino_astar.h>
+#include <obvp_solver.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace Eigen;
+
+namespace {
+// num. of bits to index [count] cells
+int getIndexBits(const int64_t count)
+{
+    int bits = 1;
+    while( (int64_t(1) << bits) < count )
+        bits++;
+
+    return bits;
+}
+
+// bits available to the 6 indices of a closed set key
+const int KeyBits = 63;
+}
+
+KinoAstar::KinoAstar(Homeworktool * _homework_tool, double _resolution, Vector3d global_xyz_l, Vector3d global_xyz_u) :
+    homework_tool(_homework_tool), lower(global_xyz_l), upper(global_xyz_u), resolution(_resolution),
+    max_vel(2.0), max_acc(2.0), primitive_time(0.8), vel_resolution(0.5), heuristic_weight(1.5),
+    discretize_step(2), max_expansions(20000), pos_bits(0), vel_bits(0),
+    shot_from(-1), shot_time(0.0), goal_pos(Vector3d::Zero()), goal_vel(Vector3d::Zero())
+{
+    updateKeyLayout();
+}
+
+void KinoAstar::setParam(
+    double _max_vel, double _max_acc, double _primitive_time, int _discretize_step,
+    double _vel_resolution, double _heuristic_weight, int _max_expansions
+)
+{
+    max_vel          = _max_vel;
+    max_acc          = _max_acc;
+    primitive_time   = _primitive_time;
+    discretize_step  = max(1, _discretize_step);
+    vel_resolution   = _vel_resolution;
+    heuristic_weight = _heuristic_weight;
+    max_expansions   = _max_expansions;
+
+    updateKeyLayout();
+
+    // with velocity bounded by max_vel, consecutive samples are at most half a voxel apart
+    const int num_inputs = discretize_step + 1;
+    const int num_steps  = max(1, int(ceil(primitive_time * sqrt(3.0) * max_vel / (0.5 * resolution))));
+
+    primitives.resize(num_inputs * num_inputs * num_inputs, num_steps + 1);
+
+    // symmetric acceleration lattice in [-max_acc, max_acc] per axis:
+    const double step = 2.0 * max_acc / discretize_step;
+    for(int i = 0; i < num_inputs; i++)
+        for(int j = 0; j < num_inputs; j++)
+            for(int k = 0; k < num_inputs; k++)
+            {
+                const int primitive = (i * num_inputs + j) * num_inputs + k;
+                primitives.acceleration(0)[primitive] = -max_acc + i * step;
+                primitives.acceleration(1)[primitive] = -max_acc + j * step;
+                primitives.acceleration(2)[primitive] = -max_acc + k * step;
+            }
+}
+
+void KinoAstar::updateKeyLayout()
+{
+    const int64_t num_voxels = int64_t(ceil(((upper - lower) / resolution).maxCoeff()));
+    pos_bits = getIndexBits(max<int64_t>(1, num_voxels));
+
+    // velocities in [-max_vel, max_vel], the upper bound itself falls into one more cell:
+    const int64_t num_cells = int64_t(floor(2.0 * max_vel / vel_resolution)) + 1;
+    vel_bits = getIndexBits(num_cells);
+
+    const int max_vel_bits = KeyBits / 3 - pos_bits;
+    if( vel_bits > max_vel_bits )
+    {
+        const double finest_resolution = 2.0 * max_vel / ((int64_t(1) << max_vel_bits) - 1);
+        ROS_WARN(
+            "[Kino A*] velocity resolution %f needs %d bits per axis, only %d fit in a key next to the position, coarsened to %f",
+            vel_resolution, vel_bits, max_vel_bits, finest_resolution
+        );
+        vel_resolution = finest_resolution;
+        vel_bits       = max_vel_bits;
+    }
+}
+
+int64_t KinoAstar::getStateKey(const Vector3d & pos, const Vector3d & vel) const
+{
+    // [pos_bits] per position index and [vel_bits] per velocity index, clamped to their ranges
+    const int64_t max_voxel = (int64_t(1) << pos_bits) - 1;
+    const int64_t max_cell  = (int64_t(1) << vel_bits) - 1;
+
+    int64_t key = 0;
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const int64_t voxel = min(max_voxel, max<int64_t>(0, int64_t(floor((pos(axis) - lower(axis)) / resolution))));
+        key = (key << pos_bits) | voxel;
+    }
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const int64_t cell = min(max_cell, max<int64_t>(0, int64_t(floor((vel(axis) + max_vel) / vel_resolution))));
+        key = (key << vel_bits) | cell;
+    }
+
+    return key;
+}
+
+double KinoAstar::getHeuristic(const Vector3d & pos, const Vector3d & vel, double & optimal_time) const
+{
+    return heuristic_weight * OBVPSolver::solve(pos, vel, goal_pos, goal_vel, optimal_time);
+}
+
+bool KinoAstar::isPrimitiveFeasible(const int primitive)
+{
+    const int last = primitives.getNumSamples() - 1;
+
+    // velocity is linear along the primitive, it suffices to bound it at the end
+    if( primitives.getVelocity(primitive, last).cwiseAbs().maxCoeff() > max_vel )
+        return false;
+
+    for(int sample = 1; sample <= last; sample++)
+    {
+        const double x = primitives.position(0, sample)[primitive];
+        const double y = primitives.position(1, sample)[primitive];
+        const double z = primitives.position(2, sample)[primitive];
+        if( !homework_tool->isObsFree(x, y, z) )
+            return false;
+    }
+
+    return true;
+}
+
+bool KinoAstar::isShotFeasible(const Vector3d & pos, const Vector3d & vel, const double T) const
+{
+    // the acceleration of the cubic is linear, so its bound is checked at both ends
+    Vector3d start_acc, end_acc;
+    OBVPSolver::getBoundaryAccelerations(pos, vel, goal_pos, goal_vel, T, start_acc, end_acc);
+    if( max(start_acc.cwiseAbs().maxCoeff(), end_acc.cwiseAbs().maxCoeff()) > max_acc )
+        return false;
+
+    const double delta_time = 0.5 * resolution / (sqrt(3.0) * max_vel);
+    const int    num_steps  = max(1, int(ceil(T / delta_time)));
+
+    Vector3d sample_pos, sample_vel;
+    for(int step = 1; step <= num_steps; step++)
+    {
+        OBVPSolver::evaluate(pos, vel, goal_pos, goal_vel, T, T * step / num_steps, sample_pos, sample_vel);
+
+        if( sample_vel.cwiseAbs().maxCoeff() > max_vel )
+            return false;
+        if( !homework_tool->isObsFree(sample_pos(0), sample_pos(1), sample_pos(2)) )
+            return false;
+    }
+
+    return true;
+}
+
+bool KinoAstar::plan(const Vector3d & start_pos, const Vector3d & start_vel, const Vector3d & target_pos, const Vector3d & target_vel)
+{
+    states.clear();
+    state_index.clear();
+    open_set = decltype(open_set)();
+
+    goal_pos  = target_pos;
+    goal_vel  = target_vel;
+    shot_from = -1;
+    shot_time = 0.0;
+
+    if( primitives.getNumPrimitives() == 0 )
+        setParam(max_vel, max_acc, primitive_time, discretize_step, vel_resolution, heuristic_weight, max_expansions);
+
+    if( !homework_tool->isObsFree(start_pos(0), start_pos(1), start_pos(2)) )
+    {
+        ROS_WARN("[Kino A*] start point is in collision");
+        return false;
+    }
+    if( !homework_tool->isObsFree(target_pos(0), target_pos(1), target_pos(2)) )
+    {
+        ROS_WARN("[Kino A*] target point is in collision");
+        return false;
+    }
+
+    const double delta_time = primitive_time / (primitives.getNumSamples() - 1);
+
+    KinoState start;
+    start.pos     = start_pos;
+    start.vel     = start_vel;
+    start.input   = Vector3d::Zero();
+    start.g_score = 0.0;
+    start.parent  = -1;
+    start.closed  = false;
+
+    double T;
+    start.f_score = getHeuristic(start_pos, start_vel, T);
+    states.push_back(start);
+    state_index[getStateKey(start_pos, start_vel)] = 0;
+    open_set.push(make_pair(start.f_score, 0));
+
+    int num_expanded = 0;
+    while( !open_set.empty() && num_expanded < max_expansions )
+    {
+        const double f_score = open_set.top().first;
+        const int    current = open_set.top().second;
+        open_set.pop();
+
+        // stale entry of a state that was expanded already, or overwritten by a cheaper one since:
+        if( states[current].closed || f_score != states[current].f_score )
+            continue;
+
+        states[current].closed = true;
+        num_expanded++;
+
+        const Vector3d pos = states[current].pos;
+        const Vector3d vel = states[current].vel;
+        const double   g   = states[current].g_score;
+
+        // analytic shot to the goal state:
+        if( OBVPSolver::solve(pos, vel, goal_pos, goal_vel, T) < numeric_limits<double>::infinity() && isShotFeasible(pos, vel, T) )
+        {
+            shot_from = current;
+            shot_time = T;
+            ROS_INFO("[Kino A*] goal reached after %d expansions, %d states", num_expanded, int(states.size()));
+            return true;
+        }
+
+        primitives.rollout(pos, vel, delta_time);
+
+        const int last = primitives.getNumSamples() - 1;
+        for(int primitive = 0; primitive < primitives.getNumPrimitives(); primitive++)
+        {
+            if( !isPrimitiveFeasible(primitive) )
+                continue;
+
+            const Vector3d end_pos = primitives.getPosition(primitive, last);
+            const Vector3d end_vel = primitives.getVelocity(primitive, last);
+            const Vector3d input   = primitives.getAcceleration(primitive);
+
+            // J = T + integral of |a|^2, the same cost as the OBVP heuristic
+            const double g_score = g + primitive_time * (1.0 + input.squaredNorm());
+
+            const int64_t key = getStateKey(end_pos, end_vel);
+            unordered_map<int64_t, int>::iterator it = state_index.find(key);
+
+            int next;
+            if( it == state_index.end() )
+            {
+                next = states.size();
+                state_index[key] = next;
+            }
+            else
+            {
+                next = it->second;
+                if( states[next].closed || g_score >= states[next].g_score )
+                    continue;
+            }
+
+            KinoState state;
+            state.pos     = end_pos;
+            state.vel     = end_vel;
+            state.input   = input;
+            state.g_score = g_score;
+            state.parent  = current;
+            state.closed  = false;
+            state.f_score = g_score + getHeuristic(end_pos, end_vel, T);
+
+            if( next == int(states.size()) )
+                states.push_back(state);
+            else
+                states[next] = state;
+
+            open_set.push(make_pair(state.f_score, next));
+        }
+    }
+
+    ROS_WARN("[Kino A*] no trajectory found after %d expansions", num_expanded);
+    return false;
+}
+
+void KinoAstar::getTrajectory(const double delta_time, vector<Vector3d> & positions, vector<Vector3d> & velocities) const
+{
+    positions.clear();
+    velocities.clear();
+
+    if( shot_from < 0 )
+        return;
+
+    vector<int> chain;
+    for(int id = shot_from; id >= 0; id = states[id].parent)
+        chain.push_back(id);
+    reverse(chain.begin(), chain.end());
+
+    positions.push_back(states[chain[0]].pos);
+    velocities.push_back(states[chain[0]].vel);
+
+    // primitives in closed form from the state of the parent:
+    const int primitive_steps = max(1, int(ceil(primitive_time / delta_time)));
+    for(size_t i = 1; i < chain.size(); i++)
+    {
+        const KinoState & parent = states[chain[i - 1]];
+        const Vector3d  & input  = states[chain[i]].input;
+
+        for(int step = 1; step <= primitive_steps; step++)
+        {
+            const double t = primitive_time * step / primitive_steps;
+            positions.push_back(parent.pos + t * (parent.vel + 0.5 * t * input));
+            velocities.push_back(parent.vel + t * input);
+        }
+    }
+
+    // analytic shot:
+    const KinoState & last = states[shot_from];
+    const int shot_steps = max(1, int(ceil(shot_time / delta_time)));
+
+    Vector3d pos, vel;
+    for(int step = 1; step <= shot_steps; step++)
+    {
+        OBVPSolver::evaluate(last.pos, last.vel, goal_pos, goal_vel, shot_time, shot_time * step / shot_steps, pos, vel);
+        positions.push_back(pos);
+        velocities.push_back(vel);
+    }
+}
@@ -0,0 +1,253 @@
+#include <kino_rrt_star.h>
+#include <obvp_solver.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace Eigen;
+
+KinoRRTstar::KinoRRTstar(Homeworktool * _homework_tool, double _resolution, Vector3d global_xyz_l, Vector3d global_xyz_u) :
+    homework_tool(_homework_tool), lower(global_xyz_l), upper(global_xyz_u), resolution(_resolution),
+    max_vel(1.0), gamma(8.0), goal_bias(0.05), generator(0),
+    goal_node(Vector3d::Zero(), Vector3d::Zero()), goal_edge_cost(numeric_limits<double>::infinity())
+{
+}
+
+void KinoRRTstar::setParam(double _max_vel, double _gamma, double _goal_bias)
+{
+    max_vel   = _max_vel;
+    gamma     = _gamma;
+    goal_bias = _goal_bias;
+}
+
+double KinoRRTstar::getSearchRadius() const
+{
+    // RRT* shrinking ball over the 6-dimensional state space, expressed as an OBVP cost bound
+    const double n = double(nodes.size() + 1);
+    return gamma * pow(log(n) / n, 1.0 / 6.0);
+}
+
+bool KinoRRTstar::isReachable(const KinoNode & from, const Vector3d & pos, const Vector3d & vel, const double radius) const
+{
+    //
+    // necessary conditions for an OBVP cost below radius, cheap enough to run against the whole tree.
+    // with e = dp - (v0 + v1) * T / 2 the cost is J(T) = T + |dv|^2 / T + 12 |e|^2 / T^3, hence
+    //
+    //     J >= 2 |dv|                              ->  |dv| <= radius / 2
+    //     T <= J, 12 |e|^2 / T^3 <= J              ->  |dp| <= |v0 + v1| * radius / 2 + radius^2 / sqrt(12)
+    //
+    const double dv = (vel - from.vel).norm();
+    if( 2.0 * dv > radius )
+        return false;
+
+    const double dp = (pos - from.pos).norm();
+    return dp <= 0.5 * (from.vel + vel).norm() * radius + radius * radius / sqrt(12.0);
+}
+
+void KinoRRTstar::evaluateEdge(
+    const Vector3d & p0, const Vector3d & v0, const Vector3d & p1, const Vector3d & v1,
+    const double T, const double t, Vector3d & pos, Vector3d & vel
+)
+{
+    OBVPSolver::evaluate(p0, v0, p1, v1, T, t, pos, vel);
+}
+
+bool KinoRRTstar::isEdgeFeasible(const Vector3d & p0, const Vector3d & v0, const Vector3d & p1, const Vector3d & v1, const double T) const
+{
+    // with velocity bounded by max_vel, consecutive samples are at most half a voxel apart
+    const double delta_time = 0.5 * resolution / (sqrt(3.0) * max_vel);
+    const int    num_steps  = max(1, int(ceil(T / delta_time)));
+
+    Vector3d pos, vel;
+    for(int step = 1; step <= num_steps; step++)
+    {
+        evaluateEdge(p0, v0, p1, v1, T, T * step / num_steps, pos, vel);
+
+        if( vel.cwiseAbs().maxCoeff() > max_vel )
+            return false;
+        if( !homework_tool->isObsFree(pos(0), pos(1), pos(2)) )
+            return false;
+    }
+
+    return true;
+}
+
+void KinoRRTstar::reparent(const int node_id, const int parent_id, const double edge_cost, const double duration)
+{
+    KinoNode & node = nodes[node_id];
+
+    vector<int> & siblings = nodes[node.parent].children;
+    siblings.erase(remove(siblings.begin(), siblings.end(), node_id), siblings.end());
+    nodes[parent_id].children.push_back(node_id);
+
+    const double delta = nodes[parent_id].cost + edge_cost - node.cost;
+    node.parent   = parent_id;
+    node.duration = duration;
+
+    // propagate the cost change to the whole subtree:
+    vector<int> open_list(1, node_id);
+    while( !open_list.empty() )
+    {
+        const int id = open_list.back();
+        open_list.pop_back();
+
+        nodes[id].cost += delta;
+        open_list.insert(open_list.end(), nodes[id].children.begin(), nodes[id].children.end());
+    }
+}
+
+bool KinoRRTstar::plan(
+    const Vector3d & start_pos, const Vector3d & start_vel,
+    const Vector3d & target_pos, const Vector3d & target_vel,
+    const int max_iterations, const double time_budget
+)
+{
+    const auto time_start = chrono::steady_clock::now();
+
+    nodes.clear();
+    nodes.reserve(max_iterations + 1);
+    nodes.push_back(KinoNode(start_pos, start_vel));
+
+    goal_node      = KinoNode(target_pos, target_vel);
+    goal_edge_cost = numeric_limits<double>::infinity();
+
+    uniform_real_distribution<double> rand_x(lower(0), upper(0));
+    uniform_real_distribution<double> rand_y(lower(1), upper(1));
+    uniform_real_distribution<double> rand_z(lower(2), upper(2));
+    uniform_real_distribution<double> rand_v(-max_vel, max_vel);
+    uniform_real_distribution<double> rand_unit(0.0, 1.0);
+
+    // (total cost, node id, edge duration)
+    vector<pair<double, pair<int, double>>> candidates;
+
+    for(int iter = 0; iter < max_iterations; iter++)
+    {
+        if( chrono::duration<double>(chrono::steady_clock::now() - time_start).count() > time_budget )
+            break;
+
+        // 1. sample:
+        Vector3d pos, vel;
+        if( rand_unit(generator) < goal_bias )
+        {
+            pos = target_pos;
+            vel = target_vel;
+        }
+        else
+        {
+            pos << rand_x(generator), rand_y(generator), rand_z(generator);
+            vel << rand_v(generator), rand_v(generator), rand_v(generator);
+        }
+
+        if( !homework_tool->isObsFree(pos(0), pos(1), pos(2)) )
+            continue;
+
+        const double radius = getSearchRadius();
+
+        // 2. choose parent, OBVP only for the nodes which pass the reachability pre-filter:
+        candidates.clear();
+        for(int i = 0; i < int(nodes.size()); i++)
+        {
+            if( !isReachable(nodes[i], pos, vel, radius) )
+                continue;
+
+            double T;
+            const double cost = Homeworktool::OptimalBVP(nodes[i].pos, nodes[i].vel, pos, vel, T);
+            if( cost <= radius )
+                candidates.push_back(make_pair(nodes[i].cost + cost, make_pair(i, T)));
+        }
+        sort(candidates.begin(), candidates.end());
+
+        int chosen = -1;
+        for(int i = 0; i < int(candidates.size()); i++)
+        {
+            const KinoNode & candidate = nodes[candidates[i].second.first];
+            if( isEdgeFeasible(candidate.pos, candidate.vel, pos, vel, candidates[i].second.second) )
+            {
+                chosen = i;
+                break;
+            }
+        }
+        if( chosen < 0 )
+            continue;
+
+        const int new_id = nodes.size();
+        nodes.push_back(KinoNode(pos, vel));
+        nodes[new_id].cost     = candidates[chosen].first;
+        nodes[new_id].duration = candidates[chosen].second.second;
+        nodes[new_id].parent   = candidates[chosen].second.first;
+        nodes[nodes[new_id].parent].children.push_back(new_id);
+
+        // 3. rewire through the new node. it is a leaf, so no cycle can be created:
+        for(int i = 1; i < new_id; i++)
+        {
+            if( !isReachable(nodes[new_id], nodes[i].pos, nodes[i].vel, radius) )
+                continue;
+
+            double T;
+            const double cost = Homeworktool::OptimalBVP(pos, vel, nodes[i].pos, nodes[i].vel, T);
+            if( cost > radius || nodes[new_id].cost + cost >= nodes[i].cost )
+                continue;
+
+            if( isEdgeFeasible(pos, vel, nodes[i].pos, nodes[i].vel, T) )
+                reparent(i, new_id, cost, T);
+        }
+
+        // 4. try to close the gap to the goal state:
+        double T;
+        const double goal_cost = Homeworktool::OptimalBVP(pos, vel, target_pos, target_vel, T);
+        if( nodes[new_id].cost + goal_cost < getCost() && isEdgeFeasible(pos, vel, target_pos, target_vel, T) )
+        {
+            goal_node.parent   = new_id;
+            goal_node.duration = T;
+            goal_edge_cost     = goal_cost;
+        }
+    }
+
+    ROS_INFO("[KinoRRTstar] %d nodes, best cost %.3f", int(nodes.size()), getCost());
+
+    return goal_node.parent >= 0;
+}
+
+double KinoRRTstar::getCost() const
+{
+    if( goal_node.parent < 0 )
+        return numeric_limits<double>::infinity();
+
+    // rewiring may have lowered the cost of the goal parent since it was connected:
+    return nodes[goal_node.parent].cost + goal_edge_cost;
+}
+
+void KinoRRTstar::getTrajectory(const double delta_time, vector<Vector3d> & positions, vector<Vector3d> & velocities) const
+{
+    positions.clear();
+    velocities.clear();
+
+    if( goal_node.parent < 0 )
+        return;
+
+    vector<const KinoNode *> states(1, &goal_node);
+    for(int id = goal_node.parent; id >= 0; id = nodes[id].parent)
+        states.push_back(&nodes[id]);
+    reverse(states.begin(), states.end());
+
+    positions.push_back(states.front()->pos);
+    velocities.push_back(states.front()->vel);
+
+    Vector3d pos, vel;
+    for(size_t i = 1; i < states.size(); i++)
+    {
+        const KinoNode & from = *states[i - 1];
+        const KinoNode & to   = *states[i];
+
+        const int num_steps = max(1, int(ceil(to.duration / delta_time)));
+        for(int step = 1; step <= num_steps; step++)
+        {
+            evaluateEdge(from.pos, from.vel, to.pos, to.vel, to.duration, to.duration * step / num_steps, pos, vel);
+            positions.push_back(pos);
+            velocities.push_back(vel);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#include <obvp_solver.h>
+
+using namespace std;
+using namespace Eigen;
+
+namespace {
+// smallest duration accepted as a solution
+const double MinTime = 0.001;
+}
+
+const int OBVPSolver::BatchSize;
+
+int OBVPSolver::solveDepressedQuartic(const double p, const double q, const double r, double roots[4])
+{
+    return obvp_closed_form::SolveDepressedQuartic(p, q, r, roots);
+}
+
+double OBVPSolver::solve(const double a, const double b, const double c, double & optimal_time)
+{
+    return obvp_closed_form::Solve(a, b, c, MinTime, optimal_time);
+}
+
+double OBVPSolver::solve(
+    const Vector3d & start_position, const Vector3d & start_velocity,
+    const Vector3d & target_position, const Vector3d & target_velocity,
+    double & optimal_time
+)
+{
+    double a, b, c;
+    getCoefficients(target_position - start_position, start_velocity, target_velocity, a, b, c);
+
+    return solve(a, b, c, optimal_time);
+}
+
+void OBVPSolver::evaluate(
+    const Vector3d & p0, const Vector3d & v0, const Vector3d & p1, const Vector3d & v1,
+    const double T, const double t, Vector3d & pos, Vector3d & vel
+)
+{
+    // p(t) = p0 + v0 * t + beta * t^2 + alpha * t^3
+    const Vector3d d  = p1 - p0 - v0 * T;
+    const Vector3d dv = v1 - v0;
+
+    const Vector3d alpha = (-2.0 / (T * T * T)) * d + (1.0 / (T * T)) * dv;
+    const Vector3d beta  = ( 3.0 / (T * T)) * d - (1.0 / T) * dv;
+
+    pos = p0 + t * (v0 + t * (beta + t * alpha));
+    vel = v0 + t * (2.0 * beta + 3.0 * t * alpha);
+}
+
+void OBVPSolver::getBoundaryAccelerations(
+    const Vector3d & p0, const Vector3d & v0, const Vector3d & p1, const Vector3d & v1,
+    const double T, Vector3d & start_acc, Vector3d & end_acc
+)
+{
+    const Vector3d d  = p1 - p0 - v0 * T;
+    const Vector3d dv = v1 - v0;
+
+    const Vector3d alpha = (-2.0 / (T * T * T)) * d + (1.0 / (T * T)) * dv;
+    const Vector3d beta  = ( 3.0 / (T * T)) * d - (1.0 / T) * dv;
+
+    start_acc = 2.0 * beta;
+    end_acc   = 2.0 * beta + 6.0 * T * alpha;
+}
+
+void OBVPSolver::solve(const int num, const double * a, const double * b, const double * c, double * cost, double * optimal_time)
+{
+    double T;
+    for(int i = 0; i < num; i++)
+    {
+        cost[i] = solve(a[i], b[i], c[i], T);
+        if( optimal_time != NULL )
+            optimal_time[i] = T;
+    }
+}
@@ -0,0 +1,188 @@
+#include <primitive_scorer.h>
+#include <obvp_solver.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace Eigen;
+
+namespace {
+// every ClearanceStride-th sample is checked for clearance, the last one always
+const int ClearanceStride = 4;
+
+bool isNearer(const Vector4i & a, const Vector4i & b)
+{
+    return a(3) < b(3);
+}
+}
+
+const int PrimitiveScorer::BatchSize;
+
+PrimitiveScorer::PrimitiveScorer(double _resolution, Vector3d global_xyz_l)
+{
+    context.library       = NULL;
+    context.homework_tool = NULL;
+    context.target_pt     = Vector3d::Zero();
+    context.duration      = 0.0;
+    context.map_lower     = global_xyz_l;
+    context.resolution    = _resolution;
+
+    setClearanceRadius(3);
+}
+
+void PrimitiveScorer::addTerm(const string & name, CostKernel kernel, const double weight)
+{
+    if( weight == 0.0 )
+        return;
+
+    Term term;
+    term.name   = name;
+    term.kernel = kernel;
+    term.weight = weight;
+    terms.push_back(term);
+}
+
+void PrimitiveScorer::setClearanceRadius(const int radius)
+{
+    context.clearance_radius = max(1, radius);
+    context.neighbourhood.clear();
+
+    // squared distances, so the nearest occupied voxel is the first one found
+    const int r = context.clearance_radius;
+    for(int x = -r; x <= r; x++)
+        for(int y = -r; y <= r; y++)
+            for(int z = -r; z <= r; z++)
+            {
+                const int squared_distance = x * x + y * y + z * z;
+                if( squared_distance < r * r )
+                    context.neighbourhood.push_back(Vector4i(x, y, z, squared_distance));
+            }
+
+    stable_sort(context.neighbourhood.begin(), context.neighbourhood.end(), isNearer);
+}
+
+void PrimitiveScorer::prepare(const TrajectoryLibrary & library, const Homeworktool * homework_tool, const Vector3d & target_pt, const double duration)
+{
+    context.library       = &library;
+    context.homework_tool = homework_tool;
+    context.target_pt     = target_pt;
+    context.duration      = duration;
+}
+
+void PrimitiveScorer::evaluate(TrajectoryLibrary & library, const int begin, const int end) const
+{
+    double term_cost[BatchSize];
+
+    for(int batch = begin; batch < end; batch += BatchSize)
+    {
+        const int batch_end = min(end, batch + BatchSize);
+        double * cost = library.cost() + batch;
+
+        fill(cost, cost + (batch_end - batch), 0.0);
+        for(size_t i = 0; i < terms.size(); i++)
+        {
+            terms[i].kernel(context, batch, batch_end, term_cost);
+
+            const double weight = terms[i].weight;
+            for(int primitive = 0; primitive < batch_end - batch; primitive++)
+                cost[primitive] += weight * term_cost[primitive];
+        }
+    }
+}
+
+int PrimitiveScorer::selectBest(const TrajectoryLibrary & library, const int k, vector<int> & best) const
+{
+    best.clear();
+
+    const double  * cost      = library.cost();
+    const uint8_t * collision = library.collision();
+    for(int primitive = 0; primitive < library.getNumPrimitives(); primitive++)
+        if( !collision[primitive] )
+            best.push_back(primitive);
+
+    // the k best in linear time, then only those k are sorted
+    auto better = [cost](const int a, const int b){ return cost[a] < cost[b] || (cost[a] == cost[b] && a < b); };
+
+    const int num_best = min<int>(max(k, 0), best.size());
+    if( num_best < int(best.size()) )
+    {
+        nth_element(best.begin(), best.begin() + num_best, best.end(), better);
+        best.resize(num_best);
+    }
+    sort(best.begin(), best.end(), better);
+
+    return num_best;
+}
+
+void PrimitiveScorer::obvpCost(const Context & context, const int begin, const int end, double * cost)
+{
+    const TrajectoryLibrary & library = *context.library;
+    const int last_sample = library.getNumSamples() - 1;
+
+    double a[BatchSize] = {0.0}, b[BatchSize] = {0.0}, c[BatchSize] = {0.0};
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const double * pos = library.position(axis, last_sample);
+        const double * vel = library.velocity(axis, last_sample);
+        const double target = context.target_pt(axis);
+
+        // the per-axis parts of getCoefficients with v0 = v1 = v: a = 3 |v|^2, b = 2 dp.v, c = |dp|^2
+        for(int primitive = begin; primitive < end; primitive++)
+        {
+            const double dp = target - pos[primitive];
+            const double v  = vel[primitive];
+            const int    i  = primitive - begin;
+
+            a[i] += 3.0 * v * v;
+            b[i] += 2.0 * dp * v;
+            c[i] += dp * dp;
+        }
+    }
+
+    OBVPSolver::solve(end - begin, a, b, c, cost, NULL);
+}
+
+void PrimitiveScorer::clearanceCost(const Context & context, const int begin, const int end, double * cost)
+{
+    const TrajectoryLibrary & library = *context.library;
+    const int    last_sample   = library.getNumSamples() - 1;
+    const double inv_radius_sq = 1.0 / double(context.clearance_radius * context.clearance_radius);
+
+    for(int primitive = begin; primitive < end; primitive++)
+    {
+        double clearance = 0.0;
+        for(int sample = ClearanceStride; sample <= last_sample + ClearanceStride - 1; sample += ClearanceStride)
+        {
+            const int s = min(sample, last_sample);
+
+            Vector3i index;
+            for(int axis = 0; axis < 3; axis++)
+                index(axis) = int(floor((library.position(axis, s)[primitive] - context.map_lower(axis)) / context.resolution));
+
+            for(size_t i = 0; i < context.neighbourhood.size(); i++)
+            {
+                const Vector4i & offset = context.neighbourhood[i];
+                if( !context.homework_tool->isObsFree(Vector3i(index + offset.head<3>())) )
+                {
+                    const double ratio = 1.0 - sqrt(offset(3) * inv_radius_sq);
+                    clearance += ratio * ratio;
+                    break;
+                }
+            }
+        }
+
+        cost[primitive - begin] = clearance;
+    }
+}
+
+void PrimitiveScorer::controlEffort(const Context & context, const int begin, const int end, double * cost)
+{
+    const TrajectoryLibrary & library = *context.library;
+    const double * acc_x = library.acceleration(0);
+    const double * acc_y = library.acceleration(1);
+    const double * acc_z = library.acceleration(2);
+
+    for(int primitive = begin; primitive < end; primitive++)
+        cost[primitive - begin] = context.duration * (acc_x[primitive] * acc_x[primitive] + acc_y[primitive] * acc_y[primitive] + acc_z[primitive] * acc_z[primitive]);
+}
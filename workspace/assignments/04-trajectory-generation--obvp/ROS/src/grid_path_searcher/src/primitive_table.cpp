@@ -0,0 +1,388 @@
+#include <primitive_table.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace Eigen;
+
+namespace {
+const char     Magic[8] = {'P', 'R', 'I', 'M', 'T', 'A', 'B', '\0'};
+const uint32_t Version  = 2;
+
+const uint64_t SectionAlignment = 64;
+
+uint64_t alignUp(const uint64_t size)
+{
+    return (size + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+}
+
+bool writePadded(FILE * file, const void * data, const size_t size)
+{
+    static const char zeros[SectionAlignment] = {0};
+
+    if( size > 0 && fwrite(data, 1, size, file) != size )
+        return false;
+
+    const size_t padding = alignUp(size) - size;
+    return padding == 0 || fwrite(zeros, 1, padding, file) == padding;
+}
+
+// [count] elements of [element_size] bytes from [offset] are aligned & inside a mapping of [size] bytes
+bool isSectionInside(const uint64_t offset, const uint64_t count, const uint64_t element_size, const uint64_t size)
+{
+    return offset % SectionAlignment == 0 && offset <= size && count <= (size - offset) / element_size;
+}
+
+// a * b, false if it exceeds [bound]
+bool multiplyBounded(const uint64_t a, const uint64_t b, const uint64_t bound, uint64_t & product)
+{
+    if( a != 0 && b > bound / a )
+        return false;
+
+    product = a * b;
+    return true;
+}
+}
+
+PrimitiveTable::PrimitiveTable() :
+    mapping(NULL), mapping_size(0), header(NULL),
+    accelerations(NULL), displacements(NULL), voxel_begin(NULL), voxels(NULL)
+{
+}
+
+PrimitiveTable::~PrimitiveTable()
+{
+    unload();
+}
+
+bool PrimitiveTable::generate(
+    const string & path, const TrajectoryLibrary & lattice, const double delta_time, const double resolution,
+    const Vector3d & vel_lower, const double vel_resolution, const Vector3i & vel_count
+)
+{
+    const int num_primitives = lattice.getNumPrimitives();
+    const int num_samples    = lattice.getNumSamples();
+    const int num_cells      = vel_count(0) * vel_count(1) * vel_count(2);
+
+    if( num_primitives <= 0 || num_samples <= 0 || num_cells <= 0 )
+    {
+        ROS_WARN("[PrimitiveTable] nothing to tabulate");
+        return false;
+    }
+
+    TrajectoryLibrary primitives;
+    if( !primitives.resize(num_primitives, num_samples) )
+        return false;
+    for(int axis = 0; axis < 3; axis++)
+        memcpy(primitives.acceleration(axis), lattice.acceleration(axis), num_primitives * sizeof(double));
+
+    const size_t cell_size = 3 * size_t(num_samples) * num_primitives;
+
+    vector<float>    cell_displacements(num_cells * cell_size);
+    vector<uint32_t> cell_voxel_begin(1, 0);
+    vector<int16_t>  cell_voxels;
+
+    unordered_set<int64_t> swept;
+    for(int cell = 0; cell < num_cells; cell++)
+    {
+        const Vector3i index(cell / (vel_count(1) * vel_count(2)), (cell / vel_count(2)) % vel_count(1), cell % vel_count(2));
+        const Vector3d velocity = vel_lower + vel_resolution * index.cast<double>();
+
+        primitives.rollout(Vector3d::Zero(), velocity, delta_time);
+
+        float * displacement = &cell_displacements[cell * cell_size];
+        for(int axis = 0; axis < 3; axis++)
+            for(int sample = 0; sample < num_samples; sample++)
+                for(int primitive = 0; primitive < num_primitives; primitive++)
+                    displacement[(size_t(axis) * num_samples + sample) * num_primitives + primitive] = primitives.position(axis, sample)[primitive];
+
+        for(int primitive = 0; primitive < num_primitives; primitive++)
+        {
+            //
+            // a start point u * resolution into its voxel, u in [0, 1), moved by d lands floor(u + d / resolution)
+            // voxels away, that is floor(d / resolution) or ceil(d / resolution) along every axis. a start velocity
+            // snapped to this cell is off by at most half a cell, which moves the sample at t by up to
+            // 0.5 * vel_resolution * t more along every axis
+            //
+            swept.clear();
+            for(int sample = 1; sample < num_samples; sample++)
+            {
+                const double residual = 0.5 * vel_resolution * sample * delta_time;
+
+                int range[3][2];
+                for(int axis = 0; axis < 3; axis++)
+                {
+                    const double d = primitives.position(axis, sample)[primitive];
+                    range[axis][0] = int(floor((d - residual) / resolution));
+                    range[axis][1] = int(ceil((d + residual) / resolution));
+                }
+
+                for(int x = range[0][0]; x <= range[0][1]; x++)
+                    for(int y = range[1][0]; y <= range[1][1]; y++)
+                        for(int z = range[2][0]; z <= range[2][1]; z++)
+                        {
+                            if( abs(x) > INT16_MAX || abs(y) > INT16_MAX || abs(z) > INT16_MAX )
+                            {
+                                ROS_WARN("[PrimitiveTable] primitives too long for the resolution");
+                                return false;
+                            }
+
+                            // in the order of the samples, so a collision check can stop at the first hit
+                            const int64_t key = ((int64_t(x) & 0xFFFF) << 32) | ((int64_t(y) & 0xFFFF) << 16) | (int64_t(z) & 0xFFFF);
+                            if( !swept.insert(key).second )
+                                continue;
+
+                            cell_voxels.push_back(x);
+                            cell_voxels.push_back(y);
+                            cell_voxels.push_back(z);
+                        }
+            }
+
+            cell_voxel_begin.push_back(cell_voxels.size() / 3);
+        }
+    }
+
+    Header table;
+    memset(&table, 0, sizeof(table));
+    memcpy(table.magic, Magic, sizeof(Magic));
+    table.version        = Version;
+    table.num_primitives = num_primitives;
+    table.num_samples    = num_samples;
+    table.delta_time     = delta_time;
+    table.resolution     = resolution;
+    table.vel_resolution = vel_resolution;
+    for(int axis = 0; axis < 3; axis++)
+    {
+        table.vel_count[axis] = vel_count(axis);
+        table.vel_lower[axis] = vel_lower(axis);
+    }
+
+    table.accelerations_offset = alignUp(sizeof(Header));
+    table.displacements_offset = table.accelerations_offset + alignUp(3 * size_t(num_primitives) * sizeof(double));
+    table.voxel_begin_offset   = table.displacements_offset + alignUp(cell_displacements.size() * sizeof(float));
+    table.voxels_offset        = table.voxel_begin_offset   + alignUp(cell_voxel_begin.size() * sizeof(uint32_t));
+    table.file_size            = table.voxels_offset        + alignUp(cell_voxels.size() * sizeof(int16_t));
+
+    FILE * file = fopen(path.c_str(), "wb");
+    if( file == NULL )
+    {
+        ROS_WARN("[PrimitiveTable] cannot open %s for writing", path.c_str());
+        return false;
+    }
+
+    vector<double> lattice_accelerations;
+    for(int axis = 0; axis < 3; axis++)
+        lattice_accelerations.insert(lattice_accelerations.end(), lattice.acceleration(axis), lattice.acceleration(axis) + num_primitives);
+
+    bool written = writePadded(file, &table, sizeof(table));
+    written = written && writePadded(file, lattice_accelerations.data(), lattice_accelerations.size() * sizeof(double));
+    written = written && writePadded(file, cell_displacements.data(), cell_displacements.size() * sizeof(float));
+    written = written && writePadded(file, cell_voxel_begin.data(), cell_voxel_begin.size() * sizeof(uint32_t));
+    written = written && writePadded(file, cell_voxels.data(), cell_voxels.size() * sizeof(int16_t));
+    written = (fclose(file) == 0) && written;
+
+    if( !written )
+    {
+        ROS_WARN("[PrimitiveTable] failed to write %s", path.c_str());
+        return false;
+    }
+
+    ROS_INFO("[PrimitiveTable] wrote %d cells of %d primitives, %.1f MB", num_cells, num_primitives, table.file_size / 1048576.0);
+    return true;
+}
+
+bool PrimitiveTable::load(const string & path)
+{
+    unload();
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if( fd < 0 )
+    {
+        ROS_WARN("[PrimitiveTable] cannot open %s", path.c_str());
+        return false;
+    }
+
+    struct stat status;
+    if( fstat(fd, &status) != 0 || size_t(status.st_size) < sizeof(Header) )
+    {
+        ROS_WARN("[PrimitiveTable] %s is not a primitive table", path.c_str());
+        close(fd);
+        return false;
+    }
+
+    void * block = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if( block == MAP_FAILED )
+    {
+        ROS_WARN("[PrimitiveTable] cannot map %s", path.c_str());
+        return false;
+    }
+
+    mapping      = block;
+    mapping_size = status.st_size;
+
+    const Header * table = static_cast<const Header *>(mapping);
+    if( memcmp(table->magic, Magic, sizeof(Magic)) != 0 || table->version != Version || table->file_size != mapping_size )
+    {
+        ROS_WARN("[PrimitiveTable] %s is not a primitive table of version %u", path.c_str(), Version);
+        unload();
+        return false;
+    }
+
+    //
+    // every section must lie inside the mapping before any pointer into it is published. the counts are
+    // bounded by the mapping size as they are multiplied, so a corrupt header cannot overflow them
+    //
+    const uint8_t * base = static_cast<const uint8_t *>(mapping);
+    const uint64_t  size = mapping_size;
+
+    bool valid = table->num_primitives > 0 && table->num_samples > 0;
+    for(int axis = 0; axis < 3; axis++)
+        valid = valid && table->vel_count[axis] > 0;
+    valid = valid && table->delta_time > 0.0 && table->resolution > 0.0 && table->vel_resolution > 0.0;
+
+    uint64_t num_cells = 0, num_entries = 0, num_displacements = 0;
+    valid = valid && multiplyBounded(table->vel_count[0], table->vel_count[1], size, num_cells);
+    valid = valid && multiplyBounded(num_cells, table->vel_count[2], size, num_cells) && num_cells <= uint64_t(INT32_MAX);
+    valid = valid && multiplyBounded(num_cells, table->num_primitives, size, num_entries);
+    valid = valid && multiplyBounded(num_entries, 3 * uint64_t(table->num_samples), size, num_displacements);
+
+    valid = valid && isSectionInside(table->accelerations_offset, 3 * uint64_t(table->num_primitives), sizeof(double), size);
+    valid = valid && isSectionInside(table->displacements_offset, num_displacements, sizeof(float), size);
+    valid = valid && isSectionInside(table->voxel_begin_offset, num_entries + 1, sizeof(uint32_t), size);
+
+    // the voxel ranges of the primitives must be ascending and end inside the voxel section
+    if( valid )
+    {
+        const uint32_t * begin = reinterpret_cast<const uint32_t *>(base + table->voxel_begin_offset);
+        for(uint64_t entry = 0; valid && entry < num_entries; entry++)
+            valid = begin[entry] <= begin[entry + 1];
+
+        valid = valid && isSectionInside(table->voxels_offset, 3 * uint64_t(begin[num_entries]), sizeof(int16_t), size);
+    }
+
+    if( !valid )
+    {
+        ROS_WARN("[PrimitiveTable] %s is corrupt, a section does not fit into the file", path.c_str());
+        unload();
+        return false;
+    }
+
+    header        = table;
+    accelerations = reinterpret_cast<const double *>(base + table->accelerations_offset);
+    displacements = reinterpret_cast<const float *>(base + table->displacements_offset);
+    voxel_begin   = reinterpret_cast<const uint32_t *>(base + table->voxel_begin_offset);
+    voxels        = reinterpret_cast<const int16_t *>(base + table->voxels_offset);
+
+    ROS_INFO("[PrimitiveTable] mapped %s, %d x %d x %d start velocities", path.c_str(), table->vel_count[0], table->vel_count[1], table->vel_count[2]);
+    return true;
+}
+
+void PrimitiveTable::unload()
+{
+    if( mapping != NULL )
+        munmap(mapping, mapping_size);
+
+    mapping       = NULL;
+    mapping_size  = 0;
+    header        = NULL;
+    accelerations = NULL;
+    displacements = NULL;
+    voxel_begin   = NULL;
+    voxels        = NULL;
+}
+
+int PrimitiveTable::findCell(const Vector3d & velocity) const
+{
+    if( header == NULL )
+        return -1;
+
+    int cell = 0;
+    for(int axis = 0; axis < 3; axis++)
+    {
+        // nearest cell, the swept voxels cover a velocity up to half a cell off
+        const double u = (velocity(axis) - header->vel_lower[axis]) / header->vel_resolution;
+        if( !(u > -0.5 && u < header->vel_count[axis] - 0.5) )
+            return -1;
+
+        const int index = min(header->vel_count[axis] - 1, max(0, int(floor(u + 0.5))));
+
+        cell = cell * header->vel_count[axis] + index;
+    }
+
+    return cell;
+}
+
+bool PrimitiveTable::isCompatible(const TrajectoryLibrary & library, const double delta_time, const double resolution) const
+{
+    if( header == NULL )
+        return false;
+
+    if( header->num_primitives != library.getNumPrimitives() || header->num_samples != library.getNumSamples() )
+        return false;
+    if( fabs(header->delta_time - delta_time) > 1e-12 || fabs(header->resolution - resolution) > 1e-12 )
+        return false;
+
+    for(int axis = 0; axis < 3; axis++)
+        for(int primitive = 0; primitive < header->num_primitives; primitive++)
+            if( fabs(accelerations[axis * header->num_primitives + primitive] - library.acceleration(axis)[primitive]) > 1e-12 )
+                return false;
+
+    return true;
+}
+
+void PrimitiveTable::lookup(const int cell, const Vector3d & start_pt, const Vector3d & start_velocity, const double delta_time, TrajectoryLibrary & library) const
+{
+    const int num_primitives = header->num_primitives;
+    const int num_samples    = header->num_samples;
+    const int stride         = library.getStride();
+
+    const float * displacement = displacements + size_t(cell) * 3 * num_samples * num_primitives;
+
+    // index of [cell] along every axis, the last axis varies fastest
+    int index[3];
+    for(int axis = 2, rest = cell; axis >= 0; axis--)
+    {
+        index[axis] = rest % header->vel_count[axis];
+        rest       /= header->vel_count[axis];
+    }
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const double * acc = library.acceleration(axis);
+        const double   p0  = start_pt(axis);
+        const double   v0  = start_velocity(axis);
+
+        // the start velocity is snapped to the cell, the displacements drift by the residual velocity
+        const double residual = v0 - (header->vel_lower[axis] + index[axis] * header->vel_resolution);
+
+        for(int sample = 0; sample < num_samples; sample++)
+        {
+            const double t = sample * delta_time;
+            const float * row = displacement + (size_t(axis) * num_samples + sample) * num_primitives;
+
+            double * pos = library.position(axis, sample);
+            double * vel = library.velocity(axis, sample);
+
+            // padding lanes keep the state of a zero input, as after a rollout
+            for(int i = 0; i < num_primitives; i++)
+                pos[i] = p0 + residual * t + row[i];
+            for(int i = num_primitives; i < stride; i++)
+                pos[i] = p0 + v0 * t;
+
+            for(int i = 0; i < stride; i++)
+                vel[i] = v0 + t * acc[i];
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <string>
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <Eigen/Eigen>
+#include <trajectory_library.h>
+#include <primitive_table.h>
+
+using namespace std;
+using namespace Eigen;
+
+// writes the primitive table of the demo_node lattice, e.g.
+//
+//     rosrun grid_path_searcher primitive_table_generator _output:=/tmp/primitives.bin
+//
+// the lattice parameters must be the ones of demo_node, a table that does not match is ignored there.
+int main(int argc, char** argv)
+{
+    ros::init(argc, argv, "primitive_table_generator");
+    ros::NodeHandle nh("~");
+
+    string output;
+    double resolution, max_input_acc, time_interval, max_vel, vel_resolution;
+    int    discretize_step, time_step;
+
+    nh.param("output",                   output,          string("primitives.bin"));
+    nh.param("map/resolution",           resolution,      0.2);
+    nh.param("planning/discretize_step", discretize_step, 2);
+    nh.param("planning/max_input_acc",   max_input_acc,   1.0);
+    nh.param("planning/time_interval",   time_interval,   1.25);
+    nh.param("planning/time_step",       time_step,       50);
+    nh.param("table/max_vel",            max_vel,         1.0);
+    nh.param("table/vel_resolution",     vel_resolution,  0.2);
+
+    // the same lattice as trajectoryLibrary in demo_node:
+    const int num_inputs = discretize_step + 1;
+
+    TrajectoryLibrary lattice;
+    if( !lattice.resize(num_inputs * num_inputs * num_inputs, time_step + 2) )
+        return 1;
+
+    const double acc_step = 2 * max_input_acc / double(discretize_step);
+    for(int i = 0; i <= discretize_step; i++)
+        for(int j = 0; j <= discretize_step; j++)
+            for(int k = 0; k <= discretize_step; k++)
+            {
+                const int primitive = (i * num_inputs + j) * num_inputs + k;
+                lattice.acceleration(0)[primitive] = -max_input_acc + i * acc_step;
+                lattice.acceleration(1)[primitive] = -max_input_acc + j * acc_step;
+                lattice.acceleration(2)[primitive] = k * acc_step + 0.1;
+            }
+
+    // start velocities in [-max_vel, max_vel] per axis:
+    const int vel_count = 2 * int(round(max_vel / vel_resolution)) + 1;
+    const Vector3d vel_lower = -Vector3d::Constant(vel_resolution * (vel_count / 2));
+
+    const bool generated = PrimitiveTable::generate(
+        output, lattice, time_interval / double(time_step), resolution, vel_lower, vel_resolution, Vector3i::Constant(vel_count)
+    );
+
+    return generated ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#include <swept_volume.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace Eigen;
+
+SweptVolume::SweptVolume(double _resolution, Vector3d global_xyz_l) :
+    lower(global_xyz_l), resolution(_resolution),
+    start_offset(Vector3d::Zero()), start_velocity(Vector3d::Zero()), duration(0.0), start_index(Vector3i::Zero())
+{
+}
+
+void SweptVolume::prepare(const TrajectoryLibrary & library, const Vector3d & start_pt, const Vector3d & _start_velocity, const double _duration)
+{
+    const int num_primitives = library.getNumPrimitives();
+
+    Vector3d offset;
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const double u = (start_pt(axis) - lower(axis)) / resolution;
+        offset(axis) = u - floor(u);
+    }
+
+    Vector3i index;
+    for(int axis = 0; axis < 3; axis++)
+        index(axis) = int(floor((start_pt(axis) - lower(axis)) / resolution));
+
+    bool changed = int(patterns.size()) != num_primitives || offset != start_offset || _start_velocity != start_velocity || _duration != duration;
+    for(int axis = 0; axis < 3 && !changed; axis++)
+        changed = !equal(library.acceleration(axis), library.acceleration(axis) + num_primitives, accelerations.begin() + axis * num_primitives);
+
+    // the same pattern somewhere else checks other voxels:
+    if( index != start_index )
+        for(size_t primitive = 0; primitive < patterns.size(); primitive++)
+            patterns[primitive].checked = false;
+    start_index = index;
+
+    if( !changed )
+        return;
+
+    start_offset   = offset;
+    start_velocity = _start_velocity;
+    duration       = _duration;
+
+    accelerations.resize(3 * num_primitives);
+    for(int axis = 0; axis < 3; axis++)
+        copy(library.acceleration(axis), library.acceleration(axis) + num_primitives, accelerations.begin() + axis * num_primitives);
+
+    // patterns keep their buffers, so a warm cache allocates nothing
+    patterns.resize(num_primitives);
+    for(int primitive = 0; primitive < num_primitives; primitive++)
+    {
+        patterns[primitive].valid   = false;
+        patterns[primitive].checked = false;
+    }
+}
+
+void SweptVolume::addObstacles(const vector<Vector3i> & voxels)
+{
+    for(size_t primitive = 0; primitive < patterns.size(); primitive++)
+    {
+        Pattern & pattern = patterns[primitive];
+        if( !pattern.checked || !pattern.free )
+            continue;
+
+        for(size_t i = 0; i < voxels.size() && pattern.free; i++)
+        {
+            const Vector3i offset = voxels[i] - start_index;
+            if( (offset.array() < pattern.box_min.array()).any() || (offset.array() > pattern.box_max.array()).any() )
+                continue;
+
+            for(size_t j = 0; j < pattern.offsets.size(); j += 3)
+                if( pattern.offsets[j] == offset(0) && pattern.offsets[j + 1] == offset(1) && pattern.offsets[j + 2] == offset(2) )
+                {
+                    pattern.free = false;
+                    break;
+                }
+        }
+    }
+}
+
+void SweptVolume::sweep(const Vector3d & acceleration, Pattern & pattern) const
+{
+    pattern.offsets.clear();
+    pattern.crossings.clear();
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+        // in voxel units from the lower corner of the start voxel: u(t) = u0 + w t + alpha t^2 / 2
+        const double u0    = start_offset(axis);
+        const double w     = start_velocity(axis) / resolution;
+        const double alpha = acceleration(axis) / resolution;
+
+        // monotone pieces, split at the vertex of the parabola:
+        double pieces[3] = {0.0, duration, duration};
+        int    num_pieces = 1;
+        if( alpha != 0.0 )
+        {
+            const double vertex = -w / alpha;
+            if( vertex > 0.0 && vertex < duration )
+            {
+                pieces[1]  = vertex;
+                num_pieces = 2;
+            }
+        }
+
+        for(int piece = 0; piece < num_pieces; piece++)
+        {
+            const double t_begin = pieces[piece];
+            const double t_end   = pieces[piece + 1];
+            const double u_begin = u0 + t_begin * (w + 0.5 * alpha * t_begin);
+            const double u_end   = u0 + t_end   * (w + 0.5 * alpha * t_end);
+
+            const bool increasing = u_end > u_begin;
+
+            // the voxel is floor(u): going up it changes on reaching k, going down on dropping below k
+            int first, last;
+            if( increasing )
+            {
+                first = int(floor(u_begin)) + 1;
+                last  = int(floor(u_end));
+            }
+            else
+            {
+                first = int(floor(u_end)) + 1;
+                last  = int(floor(u_begin));
+            }
+
+            for(int k = first; k <= last; k++)
+            {
+                // root of alpha t^2 / 2 + w t + u0 - k on this piece, in the form without cancellation
+                const double discriminant = max(0.0, w * w - 2.0 * alpha * (u0 - k));
+                const double root         = sqrt(discriminant);
+                const double denominator  = increasing ? w + root : w - root;
+
+                double t = denominator != 0.0 ? 2.0 * (k - u0) / denominator : t_begin;
+                t = min(max(t, t_begin), t_end);
+
+                Crossing crossing;
+                crossing.time = t;
+                crossing.axis = axis;
+                crossing.step = increasing ? +1 : -1;
+                pattern.crossings.push_back(crossing);
+            }
+        }
+    }
+
+    // merge the crossings of the three axes in time order:
+    stable_sort(pattern.crossings.begin(), pattern.crossings.end());
+
+    // the start voxel is where the robot already is and is left out
+    int index[3] = {0, 0, 0};
+    pattern.box_min = pattern.box_max = Vector3i::Zero();
+    for(size_t i = 0; i < pattern.crossings.size(); i++)
+    {
+        index[pattern.crossings[i].axis] += pattern.crossings[i].step;
+
+        pattern.offsets.push_back(index[0]);
+        pattern.offsets.push_back(index[1]);
+        pattern.offsets.push_back(index[2]);
+
+        pattern.box_min = pattern.box_min.cwiseMin(Vector3i(index[0], index[1], index[2]));
+        pattern.box_max = pattern.box_max.cwiseMax(Vector3i(index[0], index[1], index[2]));
+    }
+
+    pattern.valid   = true;
+    pattern.checked = false;
+}
+
+const vector<int16_t> & SweptVolume::getOffsets(const int primitive, const TrajectoryLibrary & library)
+{
+    Pattern & pattern = patterns[primitive];
+    if( !pattern.valid )
+        sweep(library.getAcceleration(primitive), pattern);
+
+    return pattern.offsets;
+}
+
+bool SweptVolume::isPrimitiveFree(const int primitive, const TrajectoryLibrary & library, const Homeworktool & homework_tool)
+{
+    const vector<int16_t> & offsets = getOffsets(primitive, library);
+
+    Pattern & pattern = patterns[primitive];
+    if( pattern.checked )
+        return pattern.free;
+
+    pattern.checked = true;
+    pattern.free    = true;
+    for(size_t i = 0; i < offsets.size() && pattern.free; i += 3)
+    {
+        const Vector3i index = start_index + Vector3i(offsets[i], offsets[i + 1], offsets[i + 2]);
+        pattern.free = homework_tool.isObsFree(index);
+    }
+
+    return pattern.free;
+}
@@ -0,0 +1,87 @@
+#include <thread_pool.h>
+
+#include <algorithm>
+
+using namespace std;
+
+ThreadPool::ThreadPool(int num_threads) :
+    job(NULL), num_tasks(0), next_task(0), num_finished(0), generation(0), stopping(false)
+{
+    if( num_threads <= 0 )
+        num_threads = max(1u, thread::hardware_concurrency());
+
+    for(int i = 1; i < num_threads; i++)
+        workers.push_back(thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<std::mutex> lock(pool_mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+
+    for(size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+int ThreadPool::runTasks(unique_lock<std::mutex> & lock)
+{
+    int num_run = 0;
+    while( next_task < num_tasks )
+    {
+        const int task = next_task++;
+
+        lock.unlock();
+        (*job)(task);
+        lock.lock();
+
+        num_run++;
+    }
+
+    return num_run;
+}
+
+void ThreadPool::workerLoop()
+{
+    long seen_generation = 0;
+
+    unique_lock<std::mutex> lock(pool_mutex);
+    while( true )
+    {
+        work_ready.wait(lock, [&]{ return stopping || generation != seen_generation; });
+        if( stopping )
+            return;
+
+        seen_generation = generation;
+
+        num_finished += runTasks(lock);
+        if( num_finished == num_tasks )
+            work_done.notify_all();
+    }
+}
+
+void ThreadPool::parallelFor(const int _num_tasks, const function<void(int)> & task)
+{
+    if( workers.empty() )
+    {
+        for(int i = 0; i < _num_tasks; i++)
+            task(i);
+        return;
+    }
+
+    unique_lock<std::mutex> lock(pool_mutex);
+    job          = &task;
+    num_tasks    = _num_tasks;
+    next_task    = 0;
+    num_finished = 0;
+    generation++;
+    work_ready.notify_all();
+
+    num_finished += runTasks(lock);
+    work_done.wait(lock, [&]{ return num_finished == num_tasks; });
+
+    job       = NULL;
+    num_tasks = 0;
+}
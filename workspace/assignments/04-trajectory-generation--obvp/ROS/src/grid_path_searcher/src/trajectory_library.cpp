@@ -0,0 +1,117 @@
+#include <trajectory_library.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+size_t alignUp(const size_t size, const size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+}
+
+const size_t TrajectoryLibrary::Alignment;
+
+TrajectoryLibrary::TrajectoryLibrary() :
+    arena(NULL), capacity(0), num_primitives(0), num_samples(0), stride(0), optimal(-1),
+    positions(NULL), velocities(NULL), accelerations(NULL), costs(NULL), collisions(NULL)
+{
+}
+
+TrajectoryLibrary::~TrajectoryLibrary()
+{
+    free(arena);
+}
+
+bool TrajectoryLibrary::resize(const int _num_primitives, const int _num_samples)
+{
+    const size_t row_stride = alignUp(max(_num_primitives, 1), Alignment / sizeof(double));
+    const size_t row_bytes  = row_stride * sizeof(double);
+
+    const size_t positions_bytes     = 3 * size_t(_num_samples) * row_bytes;
+    const size_t velocities_bytes    = positions_bytes;
+    const size_t accelerations_bytes = 3 * row_bytes;
+    const size_t costs_bytes         = row_bytes;
+    const size_t collisions_bytes    = alignUp(row_stride, Alignment);
+
+    const size_t size = positions_bytes + velocities_bytes + accelerations_bytes + costs_bytes + collisions_bytes;
+
+    if( size > capacity )
+    {
+        void * block = NULL;
+        if( posix_memalign(&block, Alignment, size) != 0 )
+        {
+            ROS_WARN("[TrajectoryLibrary] failed to allocate %zu bytes", size);
+            return false;
+        }
+
+        free(arena);
+        arena    = block;
+        capacity = size;
+    }
+
+    num_primitives = _num_primitives;
+    num_samples    = _num_samples;
+    stride         = row_stride;
+    optimal        = -1;
+
+    uint8_t * base = static_cast<uint8_t *>(arena);
+    positions      = reinterpret_cast<double *>(base);
+    velocities     = reinterpret_cast<double *>(base + positions_bytes);
+    accelerations  = reinterpret_cast<double *>(base + positions_bytes + velocities_bytes);
+    costs          = reinterpret_cast<double *>(base + positions_bytes + velocities_bytes + accelerations_bytes);
+    collisions     = base + positions_bytes + velocities_bytes + accelerations_bytes + costs_bytes;
+
+    // padding lanes take part in the vectorised rollout:
+    for(int axis = 0; axis < 3; axis++)
+        memset(acceleration(axis) + num_primitives, 0, (stride - num_primitives) * sizeof(double));
+
+    return true;
+}
+
+void TrajectoryLibrary::rollout(const Eigen::Vector3d & start_pt, const Eigen::Vector3d & start_velocity, const double delta_time)
+{
+    for(int axis = 0; axis < 3; axis++)
+    {
+        const double * acc = acceleration(axis);
+        const double p0    = start_pt(axis);
+        const double v0    = start_velocity(axis);
+
+        for(int sample = 0; sample < num_samples; sample++)
+        {
+            const double t      = sample * delta_time;
+            const double pos_t  = p0 + v0 * t;
+            const double half_t = 0.5 * t * t;
+
+            double * pos = position(axis, sample);
+            double * vel = velocity(axis, sample);
+
+            // rows are aligned and padded to whole vectors, so there is no remainder loop
+#ifdef __AVX2__
+            const __m256d pos_t_v  = _mm256_set1_pd(pos_t);
+            const __m256d v0_v     = _mm256_set1_pd(v0);
+            const __m256d half_t_v = _mm256_set1_pd(half_t);
+            const __m256d t_v      = _mm256_set1_pd(t);
+
+            for(int i = 0; i < stride; i += 4)
+            {
+                const __m256d a = _mm256_load_pd(acc + i);
+                _mm256_store_pd(pos + i, _mm256_add_pd(pos_t_v, _mm256_mul_pd(half_t_v, a)));
+                _mm256_store_pd(vel + i, _mm256_add_pd(v0_v,    _mm256_mul_pd(t_v,      a)));
+            }
+#else
+            for(int i = 0; i < stride; i++)
+            {
+                pos[i] = pos_t + half_t * acc[i];
+                vel[i] = v0    + t      * acc[i];
+            }
+#endif
+        }
+    }
+}
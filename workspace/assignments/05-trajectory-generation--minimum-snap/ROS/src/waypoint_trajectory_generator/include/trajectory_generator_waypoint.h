@@ -39,6 +39,38 @@ public:
    */
   static double EvaluatePoly(const Eigen::VectorXd &coeffs, const double t);
 
+  /**
+   * @brief get the max. norm of the [d]th derivative of a trajectory segment
+   *
+   * @param[in] coeffs polynomial coeffs of generated trajectory in normalized time t / T, K-by-(3 * N)
+   * @param[in] k trajectory segment index
+   * @param[in] T allocated time of the segment
+   * @param[in] d derivative order
+   *
+   * @return max. of the norm over [0, T], at an end or at a root of the derivative of the squared norm
+   * @note the roots are isolated by Sturm sequence, so no extremum between samples is missed
+   */
+  static double GetMaxDerivativeNorm(const Eigen::MatrixXd &coeffs, const int k, const double T, const int d);
+
+  /**
+   * @brief get the factors which stretch the segments violating the velocity or acceleration limit
+   *
+   * @param[in] coeffs polynomial coeffs of generated trajectory in normalized time t / T, K-by-(3 * N)
+   * @param[in] Time allocated time for each trajectory segment, K-by-1
+   * @param[in] velLimit max. velocity
+   * @param[in] accLimit max. acceleration
+   *
+   * @return stretch of each segment, 1.0 if it is feasible. stretching a segment by r scales its velocity by 1/r and
+   *         its acceleration by 1/r^2, so the factor is the larger of the velocity & the square root of the acceleration
+   *         ratio, plus a small margin
+   */
+  static Eigen::VectorXd GetTimeStretches(
+    const Eigen::MatrixXd &coeffs,
+    const Eigen::VectorXd &Time,
+    const double velLimit,
+    const double accLimit
+  );
+
   enum Method {
     Numeric,
     Analytic
@@ -74,20 +106,41 @@ private:
    *
    * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
    * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
-   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-1
-   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-1
-   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-1
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
    * @param[in] Time pre-computed time allocations, K-by-1
    *
-   * @return polynomial coeffs of generated trajectory, K-by-N
-   * @note the pre-assumption is no allocated segment time in Time is 0
+   * @return polynomial coeffs of generated trajectory, K-by-(D * N)
+   * @note the pre-assumption is no allocated segment time in Time is 0, all D dimensions share one factorization
    */
   Eigen::MatrixXd PolyQPGenerationNumeric(
     const int tOrder,       
     const int cOrder,    
-    const Eigen::VectorXd &Pos,
-    const Eigen::VectorXd &Vel,
-    const Eigen::VectorXd &Acc,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time
+  );
+
+  /**
+   * @brief generate minimum snap trajectory through numeric method, specialized for [COrder]th continuity
+   *
+   * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
+   * @param[in] Time pre-computed time allocations, K-by-1
+   *
+   * @return polynomial coeffs of generated trajectory, K-by-(D * N)
+   * @note factorials are compile-time tables and the per-segment blocks are fixed-size, no allocation below O(K) buffers
+   */
+  template <int COrder>
+  Eigen::MatrixXd PolyQPGenerationNumeric(
+    const int tOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
     const Eigen::VectorXd &Time
   );
 
@@ -96,20 +149,41 @@ private:
    *
    * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
    * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
-   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-1
-   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-1
-   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-1
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
    * @param[in] Time pre-computed time allocations, K-by-1
    *
-   * @return polynomial coeffs of generated trajectory, K-by-N
-   * @note the pre-assumption is no allocated segment time in Time is 0
+   * @return polynomial coeffs of generated trajectory, K-by-(D * N)
+   * @note the pre-assumption is no allocated segment time in Time is 0, all D dimensions share one factorization
    */
   Eigen::MatrixXd PolyQPGenerationAnalytic(
     const int tOrder,       
     const int cOrder,    
-    const Eigen::VectorXd &Pos,
-    const Eigen::VectorXd &Vel,
-    const Eigen::VectorXd &Acc,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time
+  );
+
+  /**
+   * @brief generate minimum snap trajectory through analytic method, specialized for [COrder]th continuity
+   *
+   * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
+   * @param[in] Time pre-computed time allocations, K-by-1
+   *
+   * @return polynomial coeffs of generated trajectory, K-by-(D * N)
+   * @note factorials are compile-time tables and the per-segment blocks are fixed-size, no allocation below O(K) buffers
+   */
+  template <int COrder>
+  Eigen::MatrixXd PolyQPGenerationAnalytic(
+    const int tOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
     const Eigen::VectorXd &Time
   );
 };
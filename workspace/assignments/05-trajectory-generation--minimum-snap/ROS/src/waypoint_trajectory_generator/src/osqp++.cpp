@@ -626,8 +626,15 @@ absl::Status OsqpSolver::SetBounds(const Ref<const VectorXd>& lower_bounds,
     }
   }
 
-  const int return_code = osqp_update_bounds(
-      workspace_.get(), lower_bounds.data(), upper_bounds.data());
+  // Clip bounds using OSQP_INFTY, as Init does. Infinite bounds passed through
+  // unclipped leave the solver running to max_iter instead of detecting
+  // infeasibility.
+  const VectorXd clipped_lower_bounds = lower_bounds.cwiseMax(-OSQP_INFTY);
+  const VectorXd clipped_upper_bounds = upper_bounds.cwiseMin(OSQP_INFTY);
+
+  const int return_code =
+      osqp_update_bounds(workspace_.get(), clipped_lower_bounds.data(),
+                         clipped_upper_bounds.data());
   if (return_code != 0) {
     return absl::UnknownError("osqp_update_bounds unexpectedly failed.");
   }
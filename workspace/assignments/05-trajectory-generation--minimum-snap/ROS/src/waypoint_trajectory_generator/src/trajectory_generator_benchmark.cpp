@@ -0,0 +1,35 @@
+#include "trajectory_generator_waypoint.h"
+#include "trajectory_benchmark.hpp"
+
+//
+// standalone benchmark of PolyQPGeneration, see trajectory_benchmark.hpp for the CSV it writes:
+//
+//     rosrun waypoint_trajectory_generator trajectory_generator_benchmark [output.csv] [num_trials] [max_segments] [seed]
+//
+// the coeffs are in normalized time t / T
+//
+
+int main(int argc, char** argv)
+{
+    TrajectoryGeneratorWaypoint trajectoryGeneratorWaypoint;
+
+    return trajectory_benchmark::Run(
+        argc, argv, "PolyQPGeneration", trajectory_benchmark::CoeffsTime::Normalized,
+        [&](
+            const trajectory_benchmark::Method method,
+            const int tOrder,
+            const int cOrder,
+            const Eigen::MatrixXd &Pos,
+            const Eigen::MatrixXd &Vel,
+            const Eigen::MatrixXd &Acc,
+            const Eigen::VectorXd &Time
+        ) {
+            return trajectoryGeneratorWaypoint.PolyQPGeneration(
+                tOrder, cOrder, Pos, Vel, Acc, Time,
+                method == trajectory_benchmark::Method::Numeric ?
+                TrajectoryGeneratorWaypoint::Method::Numeric :
+                TrajectoryGeneratorWaypoint::Method::Analytic
+            );
+        }
+    );
+}
@@ -17,6 +17,7 @@
 
 // Useful customized headers
 #include "trajectory_generator_waypoint.h"
+#include "trajectory_feasibility.hpp"
 
 using namespace std;
 using namespace Eigen;
@@ -30,6 +31,7 @@ enum TimeAllocation {
 double _vis_traj_width;
 double _Vel, _Acc;
 int    _obj_order, _dev_order, _min_order;
+int    _feasibility_iterations;
 
 std::string _time_allocation_spec;
 TimeAllocation _time_allocation;
@@ -106,6 +108,24 @@ void trajGeneration(Eigen::MatrixXd path)
         _solution_method
     );
 
+    // stretch only the segments whose max. velocity or acceleration exceeds the limits, and regenerate
+    trajectory_feasibility::StretchToLimits(
+        _polyTime,
+        _feasibility_iterations,
+        [&]() { return TrajectoryGeneratorWaypoint::GetTimeStretches(_polyCoeff, _polyTime, _Vel, _Acc); },
+        [&]() {
+            _polyCoeff = trajectoryGeneratorWaypoint.PolyQPGeneration(
+                _obj_order,
+                _dev_order, 
+                path, 
+                vel, 
+                acc, 
+                _polyTime,
+                _solution_method
+            );
+        }
+    );
+
     visWayPointPath(path);
 
     //After you finish your homework, you can use the function visWayPointTraj below to visulize your trajectory
@@ -124,6 +144,7 @@ int main(int argc, char** argv)
     nh.param("planning/min_c_order",                _min_order,                       2);
     nh.param("planning/time_allocation", _time_allocation_spec,   std::string("global"));
     nh.param("planning/solution_method", _solution_method_spec, std::string("analytic"));
+    nh.param("planning/feasibility_iterations", _feasibility_iterations,          5);
     nh.param("planning/min_c_order",                _min_order,                       2);
     nh.param("vis/vis_traj_width",             _vis_traj_width,                    0.15);
 
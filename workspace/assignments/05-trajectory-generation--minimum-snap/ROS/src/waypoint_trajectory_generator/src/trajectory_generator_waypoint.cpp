@@ -1,13 +1,15 @@
 #include "trajectory_generator_waypoint.h"
+#include "poly_kernel.hpp"
+#include "trajectory_feasibility.hpp"
 
 #include <osqp++.h>
 
 #include <ros/ros.h>
 
 #include <chrono>
+#include <cmath>
 #include <string>
 #include <vector>
-#include <map>
 
 TrajectoryGeneratorWaypoint::TrajectoryGeneratorWaypoint(){}
 TrajectoryGeneratorWaypoint::~TrajectoryGeneratorWaypoint(){}
@@ -49,6 +51,60 @@ double TrajectoryGeneratorWaypoint::EvaluatePoly(const Eigen::VectorXd &coeffs,
     return coeffs.dot(powers);
 }
 
+/**
+  * @brief get the max. norm of the [d]th derivative of a trajectory segment
+  *
+  * @param[in] coeffs polynomial coeffs of generated trajectory, K-by-(3 * N)
+  * @param[in] k trajectory segment index
+  * @param[in] T allocated time of the segment
+  * @param[in] d derivative order
+  *
+  * @return max. of the norm over [0, T]
+  */
+double TrajectoryGeneratorWaypoint::GetMaxDerivativeNorm(const Eigen::MatrixXd &coeffs, const int k, const double T, const int d) {
+    const int N = coeffs.cols() / 3;
+    // num. of coeffs of the [d]th derivative:
+    const int M = N - d;
+
+    if (d < 0 || M <= 0) {
+        return 0.0;
+    }
+
+    // [d]th derivative in real time, with coeffs in normalized time s = t / T as they are given, d/dt = d/ds / T:
+    const double timeScaling = std::pow(T, -d);
+
+    Eigen::MatrixXd derivative(M, 3);
+    for (int dim = 0; dim < 3; ++dim) {
+        for (int n = d; n < N; ++n) {
+            derivative(n - d, dim) = coeffs(k, dim * N + n) * GetFactorial(n, d) * timeScaling;
+        }
+    }
+
+    return trajectory_feasibility::GetMaxNorm(derivative);
+}
+
+/**
+  * @brief get the factors which stretch the segments violating the velocity or acceleration limit
+  *
+  * @param[in] coeffs polynomial coeffs of generated trajectory, K-by-(3 * N)
+  * @param[in] Time allocated time for each trajectory segment, K-by-1
+  * @param[in] velLimit max. velocity
+  * @param[in] accLimit max. acceleration
+  *
+  * @return stretch of each segment, 1.0 if it is feasible, otherwise its ratio to the limits with a small margin
+  */
+Eigen::VectorXd TrajectoryGeneratorWaypoint::GetTimeStretches(
+    const Eigen::MatrixXd &coeffs,
+    const Eigen::VectorXd &Time,
+    const double velLimit,
+    const double accLimit
+) {
+    return trajectory_feasibility::GetTimeStretches(
+        Time.size(), velLimit, accLimit,
+        [&](const int k, const int d) { return GetMaxDerivativeNorm(coeffs, k, Time(k), d); }
+    );
+}
+
 /**
  * @brief generate minimum snap trajectory through numeric method with OSQP C++
  *
@@ -76,36 +132,35 @@ Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGeneration(
     const int K = Time.size(); 
 
     // init:
-    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(K, 3 * N);
+    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(K, Pos.cols() * N);
 
     // tic:
     const auto tStart = std::chrono::high_resolution_clock::now();
 
-    for (int i = 0; i < Pos.cols(); ++i) {
-        switch (method) {
-            case TrajectoryGeneratorWaypoint::Method::Numeric:
-                result.block(0, i*N, K, N) = PolyQPGenerationNumeric(
-                    tOrder,
-                    cOrder,
-                    Pos.col(i),
-                    Vel.col(i),
-                    Acc.col(i),
-                    Time
-                );
-                break;
-            case TrajectoryGeneratorWaypoint::Method::Analytic:
-                result.block(0, i*N, K, N) = PolyQPGenerationAnalytic(
-                    tOrder,
-                    cOrder,
-                    Pos.col(i),
-                    Vel.col(i),
-                    Acc.col(i),
-                    Time
-                );
-                break;
-            default:
-                break;
-        }
+    // all dimensions share the time allocation, so they are solved together:
+    switch (method) {
+        case TrajectoryGeneratorWaypoint::Method::Numeric:
+            result = PolyQPGenerationNumeric(
+                tOrder,
+                cOrder,
+                Pos,
+                Vel,
+                Acc,
+                Time
+            );
+            break;
+        case TrajectoryGeneratorWaypoint::Method::Analytic:
+            result = PolyQPGenerationAnalytic(
+                tOrder,
+                cOrder,
+                Pos,
+                Vel,
+                Acc,
+                Time
+            );
+            break;
+        default:
+            break;
     }
 
     // toc:
@@ -124,44 +179,76 @@ Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGeneration(
  *
  * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
  * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
- * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-1
- * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-1
- * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-1
+ * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+ * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+ * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
  * @param[in] Time pre-computed time allocations, K-by-1
  *
- * @return polynomial coeffs of generated trajectory, K-by-N
- * @note the pre-assumption is no allocated segment time in Time is 0
+ * @return polynomial coeffs of generated trajectory, K-by-(D * N)
+ * @note the pre-assumption is no allocated segment time in Time is 0, cOrder is dispatched to a specialization for 2 or 3
  */
 Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGenerationNumeric(
     const int tOrder,       
     const int cOrder,    
-    const Eigen::VectorXd &Pos,
-    const Eigen::VectorXd &Vel,
-    const Eigen::VectorXd &Acc,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time
+) {
+    switch (cOrder) {
+        case 2:
+            return PolyQPGenerationNumeric<2>(tOrder, Pos, Vel, Acc, Time);
+        case 3:
+            return PolyQPGenerationNumeric<3>(tOrder, Pos, Vel, Acc, Time);
+        default:
+            // defaults to Eigen::MatrixXd::Zero():
+            ROS_WARN("[Minimum Snap, Numeric]: cOrder %d is not supported, only 2 & 3 are.", cOrder);
+            return Eigen::MatrixXd::Zero(Time.size(), Pos.cols() * GetNumCoeffs(cOrder));
+    }
+}
+
+template <int COrder>
+Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGenerationNumeric(
+    const int tOrder,       
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
     const Eigen::VectorXd &Time
 ) {
+    using Kernel = PolyKernel<COrder>;
+
     // num. of polynomial coeffs:
-    const auto N = GetNumCoeffs(cOrder);
+    constexpr int N = Kernel::N;
+    // num. of derivatives constrained at each waypoint:
+    constexpr int S = Kernel::S;
     // num. of trajectory segments:
-    const auto K = Time.size();
+    const int K = Time.size();
     // dim of flattened output:
-    const auto D = K * N;
+    const int D = K * N;
     // num. of inequality constraints:
-    const auto C = (
+    const int C = (
         // 1. boundary value equality constraints:
         N + 
         // 2. intermediate waypoint passing equality constraints:
         (K - 1) + 
         // 3. intermediate waypoint continuity constaints:
-        (K - 1) * (cOrder + 1)
+        (K - 1) * S
     );
+    // num. of dimensions:
+    const int numDims = Pos.cols();
 
     //
     // init output:
     //
-    //     the trajectory segment k is defined by result(k, 0) + t*(result(k, 1) + ...)
+    //     the trajectory segment k of dimension dim is defined by result(k, dim*N) + t*(result(k, dim*N + 1) + ...)
     // 
-    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(K, N);
+    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(K, numDims * N);
+
+    if (tOrder < 0 || tOrder >= N) {
+        // defaults to Eigen::MatrixXd::Zero():
+        ROS_WARN("[Minimum Snap, Numeric]: tOrder %d is out of range for %d coeffs.", tOrder, N);
+        return result;
+    }
 
     //
     // problem definition:
@@ -184,42 +271,12 @@ Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGenerationNumeric(
     // 1. init:
     Eigen::SparseMatrix<double> P(D, D);
     std::vector<Eigen::Triplet<double>> PTriplets;
+    PTriplets.reserve(K * (N - tOrder) * (N - tOrder));
     
-    // 2. cache results for objective matrix construction:
-    
-    // 2.a time power
-    Eigen::VectorXd PTimePower = Eigen::VectorXd::Ones(K);
-    for (int c = 1; c < tOrder; ++c) {
-        PTimePower = PTimePower.cwiseProduct(Time);
-    }
-    
-    // 2.b factorial
-    std::map<int, double> PFactorial;
-    for (int n = tOrder; n < N; ++n) {
-        PFactorial.insert(
-            {n, GetFactorial(n, tOrder)}
-        );
-    }
-
-    // 3. populate PTriplets:
-    for (int k = 0; k < K; ++k) {
-        const auto currentSegmentIdxOffset = k * N;
-
-        for (int m = tOrder; m < N; ++m) {
-            for (int n = tOrder; n < N; ++n) {
-                PTriplets.emplace_back(
-                    currentSegmentIdxOffset + m,
-                    currentSegmentIdxOffset + n,
-                    Time(k)*PFactorial[m]*PFactorial[n]/(
-                        (m + n - (tOrder << 1) + 1) *
-                        PTimePower(k) * PTimePower(k)
-                    )
-                );
-            }
-        }
-    }
+    // 2. populate PTriplets, the objective of segment k is the one with unit time scaled by its weight:
+    Kernel::AddObjectiveTriplets(tOrder, Time, PTriplets);
 
-    // 4. populate P:
+    // 3. populate P:
     P.setFromTriplets(std::begin(PTriplets),std::end(PTriplets));
 
     //
@@ -227,161 +284,76 @@ Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGenerationNumeric(
     //
     // 1. init:
     Eigen::SparseMatrix<double> A(C, D);
-    Eigen::VectorXd b = Eigen::VectorXd::Zero(C);
+    // one column of bounds per dimension:
+    Eigen::MatrixXd b = Eigen::MatrixXd::Zero(C, numDims);
     std::vector<Eigen::Triplet<double>> ATriplets;
+    ATriplets.reserve(S * (N + 1) + (K - 1) * (S * (N + 1) + 1));
 
-    // 2. cache results for constraint matrix construction:
-    std::map<int, Eigen::VectorXd> ATimePower;
-    std::map<int, double> AFactorial;
-
-    // 2.a init:
-    ATimePower.insert(
-        {0, Eigen::VectorXd::Ones(K)}
-    );
-    
-    auto GetAFactorialKey = [&](const int n, const int d) {
-        return d * N + n;
-    };
-    for (int n = 0; n < N; ++n) {
-        AFactorial.insert(
-            {GetAFactorialKey(n, 0), 1.0}
-        );
-    }
-
-    for (int c = 1; c <= cOrder; ++c) {
-        // 2.b time power
-        ATimePower.insert(
-            {c, ATimePower[c - 1].cwiseProduct(Time)}
-        );
-
-        // 2.c factorial
-        for (int n = c; n < N; ++n) {
-            AFactorial.insert(
-                {GetAFactorialKey(n, c), (n - c + 1)*AFactorial[GetAFactorialKey(n, c - 1)]}
-            );
-        }
-    };
+    // 2. populate ATriplets, boundary value, intermediate waypoint passing & continuity equality constraints:
+    Kernel::AddWaypointConstraintTriplets(Pos, Vel, Acc, Time, ATriplets, b);
 
-    // 3. populate ATriplets:
-    {
-        int currentConstraintIdx{0};
-
-        //
-        // 3.1 boundary value equality constraints:
-        //
-
-        // init:
-        Eigen::MatrixXd boundaryValues = Eigen::MatrixXd::Zero(2, cOrder + 1);
-        boundaryValues(0, 0) = Pos(0);
-        boundaryValues(0, 1) = Vel(0);
-        boundaryValues(0, 2) = Acc(0);
-        boundaryValues(1, 0) = Pos(K);
-        boundaryValues(1, 1) = Vel(1);
-        boundaryValues(1, 2) = Acc(1);
-
-        // populate constraints:
-        for (int c = 0; c <= cOrder; ++c) {
-            // start waypoint:
-            ATriplets.emplace_back(
-                currentConstraintIdx, c, AFactorial[GetAFactorialKey(c, c)]/ATimePower[c](0)
-            );
-            b(currentConstraintIdx) = boundaryValues(0, c);
-            
-            ++currentConstraintIdx;
-
-            // end waypoint:
-            for (int n = c; n < N; ++n) {
-                ATriplets.emplace_back(
-                    currentConstraintIdx, (K - 1)*N + n, AFactorial[GetAFactorialKey(n, c)]/ATimePower[c](K - 1)
-                );
-            }
-            b(currentConstraintIdx) = boundaryValues(1, c);
-
-            ++currentConstraintIdx;
-        }
-
-        //
-        // 3.2 intermediate waypoint passing equality constraints:
-        //
-        for (int k = 1; k < K; ++k) {
-            ATriplets.emplace_back(
-                currentConstraintIdx, k*N, 1.0
-            );
-            b(currentConstraintIdx) = Pos(k);
-
-            ++currentConstraintIdx;
-        }
-
-        //
-        // 3.3 intermediate waypoint continuity constaints:
-        //
-        for (int c = 0; c <= cOrder; ++c) {
-            for (int k = 1; k < K; ++k) {
-                // the end of previous trajectory segment:
-                for (int n = c; n < N; ++n) {
-                    ATriplets.emplace_back(
-                        currentConstraintIdx, 
-                        (k - 1) * N + n,
-                        AFactorial[GetAFactorialKey(n, c)]/ATimePower[c](k - 1)
-                    );
-                }
-
-                // should equal to the start of current trajectory segment:
-                ATriplets.emplace_back(
-                    currentConstraintIdx,
-                    k * N + c,
-                    -AFactorial[GetAFactorialKey(c, c)]/ATimePower[c](k) 
-                );
-
-                // set next constraint:
-                ++currentConstraintIdx;
-            }
-        }
-    }
-
-    // 4. populate A:
+    // 3. populate A:
     A.setFromTriplets(std::begin(ATriplets),std::end(ATriplets));
 
     //
     // solve with OSQP c++
     //
+    //     P & A only depend on the time allocation, so the solver is set up and factorizes its KKT system once,
+    //     then each dimension only updates the bounds
+    //
     osqp::OsqpInstance instance;
     instance.objective_matrix = P;
     instance.objective_vector = Eigen::VectorXd::Zero(D);
 
     instance.constraint_matrix = A;
-    instance.lower_bounds = instance.upper_bounds = b;
+    instance.lower_bounds = instance.upper_bounds = b.col(0);
 
     osqp::OsqpSolver solver;
     osqp::OsqpSettings settings;
 
     // init solver:
-    if (solver.Init(instance, settings).ok()) {
+    if (!solver.Init(instance, settings).ok()) {
+        // defaults to Eigen::MatrixXd::Zero():
+        ROS_WARN("[Minimum Snap, Numeric]: Failed to init OSQP solver.");
+        return result;
+    }
+
+    double optimalObject{0.0};
+    for (int dim = 0; dim < numDims; ++dim) {
+        // set bounds, the iterates of the previous dimension are no useful warm start:
+        if (
+            dim > 0 && (
+                !solver.SetBounds(b.col(dim), b.col(dim)).ok() ||
+                !solver.SetWarmStart(Eigen::VectorXd::Zero(D), Eigen::VectorXd::Zero(C)).ok()
+            )
+        ) {
+            // defaults to Eigen::MatrixXd::Zero():
+            ROS_WARN("[Minimum Snap, Numeric]: Failed to update OSQP solver for dimension %d.", dim);
+            continue;
+        }
+
         // solve.
         const auto exitCode = solver.Solve();
 
         if (exitCode == osqp::OsqpExitCode::kOptimal) {
             // get optimal solution
-            const auto optimalObject = solver.objective_value();
+            optimalObject += solver.objective_value();
             const auto optimalCoeffs = solver.primal_solution();
 
             //
             // format output:
             //
             for (int k = 0; k < K; ++k) {
-                result.row(k) = optimalCoeffs.segment(k * N, N);
+                result.block(k, dim * N, 1, N) = optimalCoeffs.segment(k * N, N).transpose();
             }
-
-            ROS_WARN("[Minimum Snap, Numeric]: Optimal objective is %.2f.", optimalObject);
         } else {
             // defaults to Eigen::MatrixXd::Zero():
-            ROS_WARN("[Minimum Snap, Numeric]: Failed to find the optimal solution.");
+            ROS_WARN("[Minimum Snap, Numeric]: Failed to find the optimal solution for dimension %d.", dim);
         }
-    } else {
-        // defaults to Eigen::MatrixXd::Zero():
-        ROS_WARN("[Minimum Snap, Numeric]: Failed to init OSQP solver.");
     }
 
+    ROS_WARN("[Minimum Snap, Numeric]: Optimal objective is %.2f.", optimalObject);
+
     // done:
     return result;
 }
@@ -391,270 +363,180 @@ Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGenerationNumeric(
  *
  * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
  * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
- * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-1
- * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-1
- * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-1
+ * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+ * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+ * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
  * @param[in] Time pre-computed time allocations, K-by-1
  *
- * @return polynomial coeffs of generated trajectory, K-by-N
- * @note the pre-assumption is no allocated segment time in Time is 0
+ * @return polynomial coeffs of generated trajectory, K-by-(D * N)
+ * @note the pre-assumption is no allocated segment time in Time is 0, cOrder is dispatched to a specialization for 2 or 3
  */
 Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGenerationAnalytic(
     const int tOrder,       
     const int cOrder,    
-    const Eigen::VectorXd &Pos,
-    const Eigen::VectorXd &Vel,
-    const Eigen::VectorXd &Acc,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
     const Eigen::VectorXd &Time
 ) {
+    switch (cOrder) {
+        case 2:
+            return PolyQPGenerationAnalytic<2>(tOrder, Pos, Vel, Acc, Time);
+        case 3:
+            return PolyQPGenerationAnalytic<3>(tOrder, Pos, Vel, Acc, Time);
+        default:
+            // defaults to Eigen::MatrixXd::Zero():
+            ROS_WARN("[Minimum Snap, Analytic]: cOrder %d is not supported, only 2 & 3 are.", cOrder);
+            return Eigen::MatrixXd::Zero(Time.size(), Pos.cols() * GetNumCoeffs(cOrder));
+    }
+}
+
+template <int COrder>
+Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGenerationAnalytic(
+    const int tOrder,       
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time
+) {
+    using Kernel = PolyKernel<COrder>;
+    using Block = typename Kernel::Block;
+    using State = typename Kernel::State;
+
     // num. of polynomial coeffs:
-    const auto N = GetNumCoeffs(cOrder);
+    constexpr int N = Kernel::N;
+    // num. of derivatives fixed or solved at each waypoint:
+    constexpr int S = Kernel::S;
+    // num. of decision variables at each intermediate waypoint:
+    constexpr int F = COrder;
     // num. of trajectory segments:
-    const auto K = Time.size();
-    // dim of flattened output, direct:
-    const auto D = K * N;
-    // dim of flattened output, latent:
-    const auto L = (K + 1) * (cOrder + 1);
-    const auto LFixed = (
-        // 1. boundary value equality constraints:
-        N + 
-        // 2. intermediate waypoint passing equality constraints:
-        (K - 1)
-    );
-    const auto LVariable = L - LFixed;
+    const int K = Time.size();
+    // num. of dimensions:
+    const int numDims = Pos.cols();
+
+    using Reduced = Eigen::Matrix<double, F, F>;
 
     //
     // init output:
     //
-    //     the trajectory segment k is defined by result(k, 0) + t*(result(k, 1) + ...)
+    //     the trajectory segment k of dimension dim is defined by result(k, dim*N) + t*(result(k, dim*N + 1) + ...)
     // 
-    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(K, N);
-
-    // 
-    // define objective matrix P:
-    //
-    // 1. init:
-    Eigen::SparseMatrix<double> P(D, D);
-    std::vector<Eigen::Triplet<double>> PTriplets;
-    
-    // 2. cache results for objective matrix construction:
-    // 2.a time power
-    Eigen::VectorXd PTimePower = Eigen::VectorXd::Ones(K);
-    for (int c = 1; c < tOrder; ++c) {
-        PTimePower = PTimePower.cwiseProduct(Time);
-    }
-    // 2.b factorial
-    std::map<int, double> PFactorial;
-    for (int n = tOrder; n < N; ++n) {
-        PFactorial.insert(
-            {n, GetFactorial(n, tOrder)}
-        );
-    }
+    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(K, numDims * N);
 
-    // 3. populate PTriplets:
-    for (int k = 0; k < K; ++k) {
-        const auto currentSegmentIdxOffset = k * N;
-
-        for (int m = tOrder; m < N; ++m) {
-            for (int n = tOrder; n < N; ++n) {
-                PTriplets.emplace_back(
-                    currentSegmentIdxOffset + m,
-                    currentSegmentIdxOffset + n,
-                    Time(k)*PFactorial[m]*PFactorial[n]/(
-                        (m + n - (tOrder << 1) + 1) *
-                        PTimePower(k) * PTimePower(k)
-                    )
-                );
-            }
-        }
+    if (tOrder < 0 || tOrder >= N) {
+        // defaults to Eigen::MatrixXd::Zero():
+        ROS_WARN("[Minimum Snap, Analytic]: tOrder %d is out of range for %d coeffs.", tOrder, N);
+        return result;
     }
 
-    // 4. populate P:
-    P.setFromTriplets(std::begin(PTriplets),std::end(PTriplets));
-
     //
-    // define derivative matrix M:
+    // per-segment blocks:
     //
-    // 1. init:
-    Eigen::SparseMatrix<double> M(D, D);
-    std::vector<Eigen::Triplet<double>> MTriplets;
-
-    // 2. cache results for constraint matrix construction:
-    std::map<int, Eigen::VectorXd> MTimePower;
-    std::map<int, double> MFactorial;
+    //     the derivative matrix M is block diagonal, the block of segment k maps its coeffs to its start & end state
+    //     as M_k = diag(1/T^c) * M0, so its inverse is M0^-1 * diag(T^c) in closed form and only M0, which does not
+    //     depend on the time allocation, is ever inverted. the objective block of segment k is w_k * Q0, hence the cost
+    //     of segment k in its start & end state x_k is x_k' * H_k * x_k with H_k = w_k * diag(T^c) * H0 * diag(T^c)
+    //     and H0 = M0^-T * Q0 * M0^-1. all of them are fixed-size and live on the stack
+    //
+    const Block &M0Inv = Kernel::GetM0Inverse();
+    const Block H0 = Kernel::GetStateObjective(tOrder);
 
-    // 2.a init:
-    MTimePower.insert(
-        {0, Eigen::VectorXd::Ones(K)}
-    );
-    
-    auto GetMFactorialKey = [&](const int n, const int d) {
-        return d * N + n;
+    auto GetH = [&](const int k) -> Block {
+        return Kernel::GetStateObjective(H0, tOrder, Time(k));
     };
-    for (int n = 0; n < N; ++n) {
-        MFactorial.insert(
-            {GetMFactorialKey(n, 0), 1.0}
-        );
-    }
 
-    for (int c = 1; c <= cOrder; ++c) {
-        // 2.b time power pre-computing:
-        MTimePower.insert(
-            {c, MTimePower[c - 1].cwiseProduct(Time)}
-        );
-
-        // 2.c factorial pre-computing:
-        for (int n = c; n < N; ++n) {
-            MFactorial.insert(
-                {GetMFactorialKey(n, c), (n - c + 1)*MFactorial[GetMFactorialKey(n, c - 1)]}
-            );
-        }
-    };
+    //
+    // latent variables:
+    //
+    //     U(j*S + c, dim) is the [c]th derivative at waypoint j. the positions and the boundary states are fixed,
+    //     the derivatives 1..cOrder at intermediate waypoints are the decision variables. the start & end state of
+    //     segment k are the N consecutive rows from k*S on
+    //
+    Eigen::MatrixXd U = Eigen::MatrixXd::Zero((K + 1) * S, numDims);
+    for (int j = 0; j <= K; ++j) {
+        U.row(j * S) = Pos.row(j);
+    }
+    U.row(1) = Vel.row(0);
+    U.row(2) = Acc.row(0);
+    U.row(K * S + 1) = Vel.row(1);
+    U.row(K * S + 2) = Acc.row(1);
 
-    // 3. populate MTriplets:
-    {
-        int currentStateIndex{0};
-
-        for (int k = 0; k < K; ++k) {
-            for (int c = 0; c <= cOrder; ++c) {
-                // the start state defined by current traj. seg.:
-                MTriplets.emplace_back(
-                    currentStateIndex++,
-                    k * N + c,
-                    MFactorial[GetMFactorialKey(c, c)]/MTimePower[c](k) 
-                );
+    //
+    // solve the reduced problem:
+    //
+    //     the optimality conditions couple waypoint j only with its neighbours, so the reduced matrix is
+    //     block tridiagonal with F-by-F blocks, diagonal (H_{j-1}.C + H_j.A) and off-diagonal H_j.B in
+    //     H_k = [A, B; B', C]. it only depends on the time allocation and is solved for all dimensions at once,
+    //     as a matrix right-hand side, by block forward elimination & back substitution in O(K). all buffers
+    //     are allocated up front
+    //
+    if (K > 1) {
+        // forward elimination, W_j = G_j^-1 * B_j and Z_j = G_j^-1 * Y_j for the Schur complements G_j:
+        Eigen::MatrixXd W(F, (K - 1) * F);
+        Eigen::MatrixXd Z(F, (K - 1) * numDims);
+        Eigen::Matrix<double, S, Eigen::Dynamic> g(S, numDims);
+
+        Block HPrev = GetH(0);
+        for (int j = 1; j < K; ++j) {
+            const Block HNext = GetH(j);
+
+            // gradient of the fixed latent variables, the decision variables are still zero in U:
+            g.noalias() = HPrev.template block<S, S>(S, 0) * U.template middleRows<S>((j - 1) * S);
+            g.noalias() += (HPrev.template block<S, S>(S, S) + HNext.template block<S, S>(0, 0)) * U.template middleRows<S>(j * S);
+            g.noalias() += HNext.template block<S, S>(0, S) * U.template middleRows<S>((j + 1) * S);
+
+            Reduced G = HPrev.template block<F, F>(S + 1, S + 1) + HNext.template block<F, F>(1, 1);
+            auto Y = Z.middleCols((j - 1) * numDims, numDims);
+            Y = -g.template bottomRows<F>();
+            if (j > 1) {
+                const Reduced BPrev = HPrev.template block<F, F>(1, S + 1);
+                G.noalias() -= BPrev.transpose() * W.template middleCols<F>((j - 2) * F);
+                Y.noalias() -= BPrev.transpose() * Z.middleCols((j - 2) * numDims, numDims);
             }
 
-            for (int c = 0; c <= cOrder; ++c) {
-                // the end state defined by current traj. seg.:
-                for (int n = c; n < N; ++n) {
-                    MTriplets.emplace_back(
-                        currentStateIndex, 
-                        k * N + n,
-                        MFactorial[GetMFactorialKey(n, c)]/MTimePower[c](k)
-                    );
-                }
-                ++currentStateIndex;
+            const Eigen::LLT<Reduced> decomposition(G);
+            if (decomposition.info() != Eigen::Success) {
+                ROS_WARN("[Minimum Snap, Analytic]: Failed to decompose the reduced system at waypoint %d.", j);
+                return result;
             }
-        }
-    }
-
-    // 4. populate M:
-    M.setFromTriplets(std::begin(MTriplets),std::end(MTriplets));
-
-    // 5. get inverse M:
-    // 5.1 decompose:
-    Eigen::SparseQR<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>> solver;
-    solver.compute(M);
-    if(solver.info() != Eigen::Success) {
-        // decomposition failed
-        ROS_WARN("[Minimum Snap, Analytic]: Failed to decompose derivative matrix M.");
-    }
-    // 5.2 inverse:
-    Eigen::SparseMatrix<double> I(D,D);
-    I.setIdentity();
-    auto MInv = solver.solve(I);
-    if(solver.info() != Eigen::Success) {
-        // matrix inverse failed
-        ROS_WARN("[Minimum Snap, Analytic]: Failed to compute the inverse derivative matrix M.");
-    }
 
-    //
-    // define selection matrix C:
-    //
-    // 1. init:
-    Eigen::SparseMatrix<double> C(D, L);
-    std::vector<Eigen::Triplet<double>> CTriplets;
-
-    // 2. populate CTriplets:
-    {
-        // 
-        // latent variable definition L is defined as LFixed plus LVariable
-        //
-        int currentStateIndex{0};
-
-        // 2.1 map fixed latent variables, boundary value constraints:
-        for (int c = 0; c <= cOrder; ++c) {
-            CTriplets.emplace_back(
-                c,
-                currentStateIndex,
-                1.0
-            );
-            ++currentStateIndex;
+            if (j < K - 1) {
+                W.template middleCols<F>((j - 1) * F) = decomposition.solve(HNext.template block<F, F>(1, S + 1));
+            }
+            decomposition.solveInPlace(Y);
 
-            CTriplets.emplace_back(
-                (K - 1) * N + (cOrder + 1 + c),
-                currentStateIndex,
-                1.0
-            );
-            ++currentStateIndex;
+            HPrev = HNext;
         }
 
-        // map the rest:
-        for (int c = 0; c <= cOrder; ++c) {
-            // 2.2 intermediate waypoint passing constraints will be mapped when c = 0:
-            // 2.3 actual decision latent variables will be mapped when c > 0:
-            for (int k = 1; k < K; ++k) {
-                CTriplets.emplace_back(
-                    (k - 1) * N + (cOrder + 1 + c),
-                    currentStateIndex,
-                    1.0
-                );
-
-                CTriplets.emplace_back(
-                    k * N + c,
-                    currentStateIndex,
-                    1.0
-                );
-                
-                ++currentStateIndex;
-            }
+        // back substitution:
+        U.template middleRows<F>((K - 1) * S + 1) = Z.middleCols((K - 2) * numDims, numDims);
+        for (int j = K - 2; j >= 1; --j) {
+            U.template middleRows<F>(j * S + 1) = Z.middleCols((j - 1) * numDims, numDims);
+            U.template middleRows<F>(j * S + 1).noalias() -= (
+                W.template middleCols<F>((j - 1) * F) * U.template middleRows<F>((j + 1) * S + 1)
+            );
         }
     }
 
-    // 4. populate C:
-    C.setFromTriplets(std::begin(CTriplets),std::end(CTriplets));
-
     //
-    // build problem:
+    // format output:
     //
-    // 1. define fixed variables:
-    Eigen::VectorXd outputLatent = Eigen::VectorXd::Zero(L);
-    // 1.a boundary value equality constraints:
-    outputLatent(0) = Pos(0);
-    outputLatent(1) = Pos(1);
-    outputLatent(2) = Vel(0);
-    outputLatent(3) = Vel(1);
-    outputLatent(4) = Acc(0);
-    outputLatent(5) = Acc(1);
-    // 1.b intermediate waypoint passing equality constraints:
-    for (int k = 1; k < K; ++k) {
-        outputLatent(N + k - 1) = Pos(k);
-    }
-
-    // 2. define A & b for least squared:
-    Eigen::MatrixXd PDense(C.transpose() * MInv.transpose() * P * MInv * C);
-
-    const Eigen::MatrixXd& A = PDense.block(LFixed, LFixed, LVariable, LVariable);
-    const Eigen::VectorXd b = -PDense.block(LFixed,      0, LVariable,    LFixed)*outputLatent.segment(0, LFixed);
-
-    // 3. get latent output:
-    outputLatent.segment(LFixed, LVariable) = A.colPivHouseholderQr().solve(b);
+    double optimalObject{0.0};
+    for (int k = 0; k < K; ++k) {
+        const Block H = GetH(k);
+        const State timeScalings = Kernel::GetTimeScalings(Time(k));
 
-    // 4. get direct output:
-    const Eigen::VectorXd outputDirect = MInv * C * outputLatent;
+        for (int dim = 0; dim < numDims; ++dim) {
+            const State x = U.template block<N, 1>(k * S, dim);
 
-    // 5. get optimal objective:
-    const auto optimalObject = (0.50 * outputDirect.transpose() * P * outputDirect);
-    ROS_WARN("[Minimum Snap, Analytic]: Optimal objective is %.2f.", optimalObject(0, 0));
+            optimalObject += 0.50 * x.dot(H * x);
 
-    //
-    // format output:
-    //
-    for (int k = 0; k < K; ++k) {
-        result.row(k) = outputDirect.segment(k * N, N);
+            result.template block<1, N>(k, dim * N) = (M0Inv * x.cwiseProduct(timeScalings)).transpose();
+        }
     }
 
+    ROS_WARN("[Minimum Snap, Analytic]: Optimal objective is %.2f.", optimalObject);
+
     // done:
     return result;
 }
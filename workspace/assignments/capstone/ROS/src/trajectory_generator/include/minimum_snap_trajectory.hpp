@@ -0,0 +1,164 @@
+#ifndef QUAD_PLANNER_MINIMUM_SNAP_TRAJECTORY_HPP_
+#define QUAD_PLANNER_MINIMUM_SNAP_TRAJECTORY_HPP_
+
+#include "poly_kernel.hpp"
+
+#include <Eigen/Eigen>
+#include <vector>
+
+/**
+ * @brief minimum snap trajectory through waypoints which keeps the factorization of its banded system, in the spirit of MINCO
+ *
+ * @note the trajectory is defined by its waypoints & segment times. the block tridiagonal system of the free
+ *       derivatives at intermediate waypoints only depends on the times, so moving waypoints re-solves with the
+ *       stored factorization and changing times refactorizes, both in O(K). the gradient of a cost of the coeffs &
+ *       times w.r.t. the waypoints & times takes one more O(K) solve with the same factorization
+ */
+template <int COrder>
+class MinimumSnapTrajectory {
+public:
+  using Kernel = PolyKernel<COrder>;
+
+  // num. of derivatives fixed or solved at each waypoint:
+  static constexpr int S = Kernel::S;
+  // num. of polynomial coeffs:
+  static constexpr int N = Kernel::N;
+  // num. of decision variables at each intermediate waypoint:
+  static constexpr int F = COrder;
+
+  /**
+   * @param[in] tOrder the L2-norm of [tOrder]th derivative of the trajectory is the objective function, in [0, N)
+   */
+  explicit MinimumSnapTrajectory(const int tOrder);
+
+  /**
+   * @brief generate the trajectory from scratch
+   *
+   * @param[in] Pos waypoints, (K + 1)-by-D
+   * @param[in] Vel boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc boundary(start & goal) acceleration specifications, 2-by-D
+   * @param[in] Time segment times, K-by-1, all positive
+   *
+   * @return true if the banded system could be factorized
+   */
+  bool Generate(
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time
+  );
+
+  /**
+   * @brief move the waypoints, re-solved with the stored factorization
+   *
+   * @param[in] Pos waypoints, (K + 1)-by-D with the same K & D as generated
+   */
+  void SetWaypoints(const Eigen::MatrixXd &Pos);
+
+  /**
+   * @brief change the segment times, refactorized & re-solved
+   *
+   * @param[in] Time segment times, K-by-1 with the same K as generated, all positive
+   *
+   * @return true if the banded system could be factorized
+   */
+  bool SetTimes(const Eigen::VectorXd &Time);
+
+  int GetNumSegments() const { return time.size(); }
+
+  int GetNumDims() const { return U.cols(); }
+
+  const Eigen::VectorXd &GetTimes() const { return time; }
+
+  /**
+   * @brief get the derivatives 0..COrder at each waypoint, the start & end state of segment k are the N rows from k*S on
+   *
+   * @return ((K + 1) * S)-by-D
+   */
+  const Eigen::MatrixXd &GetStates() const { return U; }
+
+  /**
+   * @brief get the polynomial coeffs in time t from the start of each segment, as TrajectoryOptimizer::GenerateTrajectory
+   *
+   * @return K-by-(D * N)
+   */
+  Eigen::MatrixXd GetCoeffs() const;
+
+  /**
+   * @brief get the objective, summed over all dimensions
+   *
+   * @note half the integral of the squared [tOrder]th derivative, on the scale of the QP objective 0.5 * x'Px
+   */
+  double GetObjective() const;
+
+  /**
+   * @brief get the gradient of the objective w.r.t. the waypoints & segment times
+   *
+   * @param[out] gradPos (K + 1)-by-D
+   * @param[out] gradTime K-by-1
+   */
+  void GetObjectiveGradient(Eigen::MatrixXd &gradPos, Eigen::VectorXd &gradTime) const;
+
+  /**
+   * @brief propagate the gradient of a cost w.r.t. the coeffs & segment times to the waypoints & segment times
+   *
+   * @param[in] gradCoeffs partial derivatives w.r.t. the coeffs of GetCoeffs, K-by-(D * N)
+   * @param[in] gradTimePartial partial derivatives w.r.t. the segment times at fixed coeffs, K-by-1
+   * @param[out] gradPos total derivatives w.r.t. the waypoints, (K + 1)-by-D
+   * @param[out] gradTime total derivatives w.r.t. the segment times, K-by-1
+   */
+  void PropagateGradient(
+    const Eigen::MatrixXd &gradCoeffs,
+    const Eigen::VectorXd &gradTimePartial,
+    Eigen::MatrixXd &gradPos,
+    Eigen::VectorXd &gradTime
+  ) const;
+
+private:
+  using Block = typename Kernel::Block;
+  using State = typename Kernel::State;
+  using Reduced = Eigen::Matrix<double, F, F>;
+
+  /**
+   * @brief compute the segment objectives and factorize the banded system for the current times
+   */
+  bool Factorize();
+
+  /**
+   * @brief solve the free derivatives for the fixed ones in U
+   */
+  void Solve();
+
+  /**
+   * @brief solve the banded system in place with the stored factorization
+   *
+   * @param[in,out] R right-hand side & solution, ((K - 1) * F)-by-D, F rows per intermediate waypoint
+   */
+  void SolveReduced(Eigen::MatrixXd &R) const;
+
+  /**
+   * @brief multiply by the objective of all segments, the block tridiagonal sum of the segment objectives
+   *
+   * @param[in] V ((K + 1) * S)-by-D in the layout of U
+   * @param[out] HV ((K + 1) * S)-by-D
+   */
+  void MultiplyObjective(const Eigen::MatrixXd &V, Eigen::MatrixXd &HV) const;
+
+  const int tOrder;
+
+  // objective of a segment with unit time in its start & end state & the exponents of T in the ones of the segments:
+  const Block H0;
+  const Block E;
+
+  Eigen::VectorXd time;
+  Eigen::MatrixXd U;
+
+  // objective of each segment in its start & end state:
+  std::vector<Block, Eigen::aligned_allocator<Block>> H;
+
+  // factorization of the banded system, the Schur complement G_j & W_j = G_j^-1 * B_j of each intermediate waypoint:
+  std::vector<Eigen::LLT<Reduced>, Eigen::aligned_allocator<Eigen::LLT<Reduced>>> decompositions;
+  Eigen::MatrixXd W;
+};
+
+#endif // QUAD_PLANNER_MINIMUM_SNAP_TRAJECTORY_HPP_
@@ -56,6 +56,8 @@ private:
 		);
 	}
 
+	bool isFree(const Eigen::Vector3i &lower, const Eigen::Vector3i &upper) const;
+
 	double getHeu(
 		GridNodePtr sourcePtr, 
 		GridNodePtr targetPtr, 
@@ -107,6 +109,37 @@ public:
 		size_t segment_index
 	);
 
+	/**
+	  * @brief generate safe flight corridor as one axis-aligned free box per segment
+	  *
+	  * @param[in] path raw waypoints from path finder
+	  * @param[in] input critical waypoint indices
+	  * @param[in] max_inflation max. num. of voxels each face of the box is pushed out
+	  * @param[out] corridor box bounds of each segment, K-by-6 as lower x, y, z & upper x, y, z
+	  *
+	  * @return critical waypoint indices, with segments split at their mid waypoint until the bounding box of their
+	  *         A* path is free. segments which can not be split that way are bounded by the map only
+	  */
+	std::vector<size_t> GenerateCorridor(
+		const std::vector<Eigen::Vector3d> &path,
+		const std::vector<size_t> &input,
+		const int max_inflation,
+		Eigen::MatrixXd &corridor
+	);
+
+	/**
+	  * @brief detect collision on planned trajectory by the convex hulls of its Bezier curves
+	  *
+	  * @param[in] control_points control points of each trajectory segment, K-by-(3 * M) as TrajectoryOptimizer::GetControlPoints
+	  * @param[in] max_subdivisions max. num. of times a piece whose hull box is occupied is halved by de Casteljau
+	  *
+	  * @return index of first trajectory segment which can not be certified free
+	  */
+	int DetectCollision(
+		const Eigen::MatrixXd &control_points,
+		const int max_subdivisions
+	);
+
 	/**
 	  * @brief detect collision on planned trajectory
 	  *
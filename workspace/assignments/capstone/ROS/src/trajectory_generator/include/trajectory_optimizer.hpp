@@ -2,8 +2,13 @@
 #define QUAD_PLANNER_TRAJECTORY_OPTIMIZER_HPP_
 
 #include <Eigen/Eigen>
+#include <memory>
 #include <vector>
 
+namespace osqp {
+class OsqpSolver;
+}
+
 class TrajectoryOptimizer {
 public:
   TrajectoryOptimizer();
@@ -56,6 +61,50 @@ public:
    */
   static Eigen::Vector3d GetVel(const Eigen::MatrixXd &coeffs, const int k, const double t);
 
+  /**
+   * @brief get the control points of the Bezier curves of the [d]th derivative of the trajectory
+   *
+   * @param[in] coeffs polynomial coefficients, K-by-(3 * N)
+   * @param[in] time allocated time for each trajectory segment, K-by-1
+   * @param[in] d derivative order, in [0, N)
+   *
+   * @return control points of each segment, K-by-(3 * (N - d)). the [d]th derivative of segment k stays in the
+   *         convex hull of its control points, which certifies bounds & collision checks without sampling
+   */
+  static Eigen::MatrixXd GetControlPoints(const Eigen::MatrixXd &coeffs, const Eigen::VectorXd &time, const int d = 0);
+
+  /**
+   * @brief get the max. norm of the [d]th derivative of a trajectory segment
+   *
+   * @param[in] coeffs polynomial coefficients, K-by-(3 * N)
+   * @param[in] k trajectory segment index
+   * @param[in] T allocated time of the segment
+   * @param[in] d derivative order
+   *
+   * @return max. of the norm over [0, T], at an end or at a root of the derivative of the squared norm
+   * @note the roots are isolated by Sturm sequence, so no extremum between samples is missed
+   */
+  static double GetMaxDerivativeNorm(const Eigen::MatrixXd &coeffs, const int k, const double T, const int d);
+
+  /**
+   * @brief get the factors which stretch the segments violating the velocity or acceleration limit
+   *
+   * @param[in] coeffs polynomial coefficients, K-by-(3 * N)
+   * @param[in] time allocated time for each trajectory segment, K-by-1
+   * @param[in] velLimit max. velocity
+   * @param[in] accLimit max. acceleration
+   *
+   * @return stretch of each segment, 1.0 if it is feasible. stretching a segment by r scales its velocity by 1/r and
+   *         its acceleration by 1/r^2, so the factor is the larger of the velocity & the square root of the acceleration
+   *         ratio, plus a small margin
+   */
+  static Eigen::VectorXd GetTimeStretches(
+    const Eigen::MatrixXd &coeffs,
+    const Eigen::VectorXd &time,
+    const double velLimit,
+    const double accLimit
+  );
+
   enum class TimeAllocation {
     SegmentTrapezoidal,
     GlobalTrapezoidal
@@ -82,11 +131,111 @@ public:
     const TimeAllocation strategy = TimeAllocation::GlobalTrapezoidal
   );
 
+  /**
+   * @brief optimize the time allocation for the minimum snap objective plus weighted total time
+   *
+   * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
+   * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
+   * @param[in] Time initial time allocations, e.g. from AllocateTimes, K-by-1
+   * @param[in] timeWeight weight of the total time
+   * @param[in] maxIterations max. num. of quasi-Newton steps
+   *
+   * @return optimized time allocations, K-by-1, the initial ones for K = 1 or a non-positive weight
+   * @note L-BFGS in log time with analytic gradients from the states of the banded solve, O(K) per step
+   */
+  static Eigen::VectorXd OptimizeTimes(
+    const int tOrder,
+    const int cOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const double timeWeight,
+    const int maxIterations
+  );
+
+  /**
+   * @brief solve the time-optimal OBVP of the double integrator, J = T + integral of |a|^2, in closed form
+   *
+   * @param[in] a |v0|^2 + v0.v1 + |v1|^2
+   * @param[in] b dp.(v0 + v1)
+   * @param[in] c |dp|^2
+   * @param[out] optimalTime optimal traversal time, 0.0 if there is no positive one
+   *
+   * @return optimal cost, infinity if there is no positive traversal time
+   * @note allocation free and silent, the stationarity condition T^4 - 4aT^2 + 24bT - 36c = 0 is solved with Ferrari's method
+   */
+  static double SolveOBVP(const double a, const double b, const double c, double &optimalTime);
+
+  /**
+   * @brief batched version of SolveOBVP over coefficient arrays
+   *
+   * @param[in] num num. of boundary value problems
+   * @param[in] a coefficient arrays as in SolveOBVP, num-by-1
+   * @param[in] b coefficient arrays as in SolveOBVP, num-by-1
+   * @param[in] c coefficient arrays as in SolveOBVP, num-by-1
+   * @param[out] cost optimal costs, num-by-1
+   * @param[out] optimalTime optimal traversal times, num-by-1, may be nullptr
+   */
+  static void SolveOBVP(const int num, const double *a, const double *b, const double *c, double *cost, double *optimalTime);
+
   enum class Solver {
     Numeric,
     Analytic
   };
 
+  /**
+   * @brief OSQP solver of the numeric method kept alive across calls, e.g. the refinements of one path
+   *
+   * @note for the same num. of segments P & A keep their sparsity, so they are updated in place and each dimension
+   *       is warm-started from its previous iterate. after a waypoint insertion the solver is set up again and
+   *       warm-started from the previous trajectory, split at the new waypoint
+   */
+  class NumericSession {
+  public:
+    NumericSession();
+
+    ~NumericSession();
+
+    /**
+     * @brief drop the solver and the previous iterates, the next solve starts cold
+     */
+    void Reset();
+
+    /**
+     * @brief get num. of OSQP iterations of the last solve, summed over all dimensions
+     */
+    int GetNumIterations() const { return numIterations; }
+
+    /**
+     * @brief whether the last solve started from a previous iterate
+     */
+    bool IsWarmStarted() const { return isWarmStarted; }
+
+  private:
+    friend class TrajectoryOptimizer;
+
+    std::unique_ptr<osqp::OsqpSolver> solver;
+
+    // structure of the problem the solver is set up for:
+    int tOrder{-1};
+    int cOrder{-1};
+    int numSegments{0};
+    int numConstraints{0};
+    int numDims{0};
+
+    // waypoints, (K + 1)-by-D, and per dimension iterates, (K * N)-by-D & C-by-D, of the last solve:
+    Eigen::MatrixXd Pos;
+    Eigen::MatrixXd primal;
+    Eigen::MatrixXd dual;
+
+    int numIterations{0};
+    bool isWarmStarted{false};
+  };
+
   /**
    * @brief generate minimum snap trajectory
    *
@@ -97,6 +246,7 @@ public:
    * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
    * @param[in] Time pre-computed time allocations, K-by-1
    * @param[in] method solution method, defaults to Analytic
+   * @param[in,out] session numeric solver session reused across calls, only used by Numeric, may be nullptr
    *
    * @return polynomial coeffs of generated trajectory, K-by-(D * N)
    * @note the pre-assumption is no allocated segment time in Time is 0
@@ -108,7 +258,37 @@ public:
     const Eigen::MatrixXd &Vel,
     const Eigen::MatrixXd &Acc,
     const Eigen::VectorXd &Time,
-    Solver method = Solver::Analytic
+    Solver method = Solver::Analytic,
+    NumericSession *session = nullptr
+  );
+
+  /**
+   * @brief generate minimum snap trajectory which stays in a safe flight corridor
+   *
+   * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
+   * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
+   * @param[in] Time pre-computed time allocations, K-by-1
+   * @param[in] Corridor inequality constraints, axis-aligned box of each segment, K-by-(2 * D) as lower & upper bounds
+   * @param[in] numSamples num. of evenly spaced samples within each segment which should stay in its box,
+   *                       0 to keep the control points of its Bezier curve in the box instead
+   * @param[in,out] session numeric solver session reused across calls, may be nullptr
+   *
+   * @return polynomial coeffs of generated trajectory, K-by-(D * N), empty if none stays in the corridor
+   * @note the boxes are inequality constraints, so the numeric method is used for any K
+   */
+  static Eigen::MatrixXd GenerateSafeTrajectory(
+    const int tOrder,
+    const int cOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const Eigen::MatrixXd &Corridor,
+    const int numSamples,
+    NumericSession *session = nullptr
   );
 
 private:
@@ -123,6 +303,18 @@ private:
    */
   static double EvaluatePoly(const Eigen::VectorXd &coeffs, const int d, const double t);
 
+  /**
+   * @brief find real roots of depressed quartic x^4 + p*x^2 + q*x + r
+   *
+   * @param[in] p quadratic coeff
+   * @param[in] q linear coeff
+   * @param[in] r constant coeff
+   * @param[out] roots real roots, polished by Newton iterations
+   *
+   * @return num. of real roots
+   */
+  static int SolveDepressedQuartic(const double p, const double q, const double r, double roots[4]);
+
   /**
    * @brief allocate traversal time for single trajectory segment with OBVP
    *
@@ -193,21 +385,54 @@ private:
    *
    * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
    * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
-   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-1
-   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-1
-   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-1
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
    * @param[in] Time pre-computed time allocations, K-by-1
+   * @param[in] Corridor inequality constraints, box of each segment, K-by-(2 * D), or empty for no corridor
+   * @param[in] numSamples num. of samples within each segment which should stay in its box, 0 for its control points
+   * @param[in,out] session solver session reused across calls, may be nullptr
    *
-   * @return polynomial coeffs of generated trajectory, K-by-N
-   * @note the pre-assumption is no allocated segment time in Time is 0
+   * @return polynomial coeffs of generated trajectory, K-by-(D * N), empty if none stays in a given corridor
+   * @note the pre-assumption is no allocated segment time in Time is 0, all D dimensions share one factorization
    */
   static Eigen::MatrixXd DoTrajectoryGenerationNumerically(
     const int tOrder,       
     const int cOrder,    
-    const Eigen::VectorXd &Pos,
-    const Eigen::VectorXd &Vel,
-    const Eigen::VectorXd &Acc,
-    const Eigen::VectorXd &Time
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const Eigen::MatrixXd &Corridor,
+    const int numSamples,
+    NumericSession *session
+  );
+
+  /**
+   * @brief generate minimum snap trajectory through numeric method, specialized for [COrder]th continuity
+   *
+   * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
+   * @param[in] Time pre-computed time allocations, K-by-1
+   * @param[in] Corridor inequality constraints, box of each segment, K-by-(2 * D), or empty for no corridor
+   * @param[in] numSamples num. of samples within each segment which should stay in its box, 0 for its control points
+   * @param[in,out] session solver session reused across calls, may be nullptr
+   *
+   * @return polynomial coeffs of generated trajectory, K-by-(D * N), empty if none stays in a given corridor
+   * @note factorials are compile-time tables and the per-segment blocks are fixed-size, no allocation below O(K) buffers
+   */
+  template <int COrder>
+  static Eigen::MatrixXd DoTrajectoryGenerationNumerically(
+    const int tOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const Eigen::MatrixXd &Corridor,
+    const int numSamples,
+    NumericSession *session
   );
 
   /**
@@ -215,22 +440,67 @@ private:
    *
    * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
    * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
-   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-1
-   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-1
-   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-1
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
    * @param[in] Time pre-computed time allocations, K-by-1
    *
-   * @return polynomial coeffs of generated trajectory, K-by-N
-   * @note the pre-assumption is no allocated segment time in Time is 0
+   * @return polynomial coeffs of generated trajectory, K-by-(D * N)
+   * @note the pre-assumption is no allocated segment time in Time is 0, all D dimensions share one factorization
    */
   static Eigen::MatrixXd DoTrajectoryGenerationAnalytically(
     const int tOrder,       
     const int cOrder,    
-    const Eigen::VectorXd &Pos,
-    const Eigen::VectorXd &Vel,
-    const Eigen::VectorXd &Acc,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
     const Eigen::VectorXd &Time
   );
+
+  /**
+   * @brief generate minimum snap trajectory through analytic method, specialized for [COrder]th continuity
+   *
+   * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
+   * @param[in] Time pre-computed time allocations, K-by-1
+   *
+   * @return polynomial coeffs of generated trajectory, K-by-(D * N)
+   * @note factorials are compile-time tables and the per-segment blocks are fixed-size, no allocation below O(K) buffers
+   */
+  template <int COrder>
+  static Eigen::MatrixXd DoTrajectoryGenerationAnalytically(
+    const int tOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time
+  );
+
+  /**
+   * @brief optimize the time allocation, specialized for [COrder]th continuity
+   *
+   * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
+   * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+   * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
+   * @param[in] Time initial time allocations, K-by-1
+   * @param[in] timeWeight weight of the total time
+   * @param[in] maxIterations max. num. of quasi-Newton steps
+   *
+   * @return optimized time allocations, K-by-1
+   */
+  template <int COrder>
+  static Eigen::VectorXd DoTimesOptimization(
+    const int tOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const double timeWeight,
+    const int maxIterations
+  );
 };
 
 #endif // QUAD_PLANNER_TRAJECTORY_OPTIMIZER_HPP_
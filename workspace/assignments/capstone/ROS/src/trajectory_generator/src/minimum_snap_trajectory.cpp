@@ -0,0 +1,324 @@
+#include "minimum_snap_trajectory.hpp"
+
+#include <ros/ros.h>
+
+template <int COrder>
+MinimumSnapTrajectory<COrder>::MinimumSnapTrajectory(const int tOrder) :
+    tOrder(tOrder),
+    H0(Kernel::GetStateObjective(tOrder)),
+    E(Kernel::GetObjectiveExponents(tOrder)) {}
+
+template <int COrder>
+bool MinimumSnapTrajectory<COrder>::Generate(
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time
+) {
+    // num. of trajectory segments:
+    const int K = Time.size();
+
+    //
+    // latent variables:
+    //
+    //     U(j*S + c, dim) is the [c]th derivative at waypoint j. the positions and the boundary states are fixed,
+    //     the derivatives 1..cOrder at intermediate waypoints are the decision variables. the start & end state of
+    //     segment k are the N consecutive rows from k*S on
+    //
+    time = Time;
+    U = Eigen::MatrixXd::Zero((K + 1) * S, Pos.cols());
+    for (int j = 0; j <= K; ++j) {
+        U.row(j * S) = Pos.row(j);
+    }
+    U.row(1) = Vel.row(0);
+    U.row(2) = Acc.row(0);
+    U.row(K * S + 1) = Vel.row(1);
+    U.row(K * S + 2) = Acc.row(1);
+
+    if (!Factorize()) {
+        return false;
+    }
+
+    Solve();
+
+    return true;
+}
+
+template <int COrder>
+void MinimumSnapTrajectory<COrder>::SetWaypoints(const Eigen::MatrixXd &Pos) {
+    const int K = time.size();
+    for (int j = 0; j <= K; ++j) {
+        U.row(j * S) = Pos.row(j);
+    }
+
+    Solve();
+}
+
+template <int COrder>
+bool MinimumSnapTrajectory<COrder>::SetTimes(const Eigen::VectorXd &Time) {
+    time = Time;
+
+    if (!Factorize()) {
+        return false;
+    }
+
+    Solve();
+
+    return true;
+}
+
+template <int COrder>
+Eigen::MatrixXd MinimumSnapTrajectory<COrder>::GetCoeffs() const {
+    const int K = time.size();
+    const int numDims = U.cols();
+    const Block &M0Inv = Kernel::GetM0Inverse();
+
+    //
+    // the coeffs of segment k are M0^-1 * diag(T^c) times its state, scaled from normalized time s = t / T back to t
+    //
+    Eigen::MatrixXd coeffs(K, numDims * N);
+    for (int k = 0; k < K; ++k) {
+        const State timeScalings = Kernel::GetTimeScalings(time(k));
+
+        State coeffScalings = State::Ones();
+        for (int n = 1; n < N; ++n) {
+            coeffScalings(n) = coeffScalings(n - 1) / time(k);
+        }
+
+        for (int dim = 0; dim < numDims; ++dim) {
+            const State x = U.template block<N, 1>(k * S, dim);
+            coeffs.template block<1, N>(k, dim * N) = (M0Inv * x.cwiseProduct(timeScalings)).cwiseProduct(coeffScalings).transpose();
+        }
+    }
+
+    return coeffs;
+}
+
+template <int COrder>
+double MinimumSnapTrajectory<COrder>::GetObjective() const {
+    const int K = time.size();
+
+    double objective{0.0};
+    for (int k = 0; k < K; ++k) {
+        const auto x = U.template middleRows<N>(k * S);
+        objective += 0.50 * (H[k] * x).cwiseProduct(x).sum();
+    }
+
+    return objective;
+}
+
+template <int COrder>
+void MinimumSnapTrajectory<COrder>::GetObjectiveGradient(Eigen::MatrixXd &gradPos, Eigen::VectorXd &gradTime) const {
+    const int K = time.size();
+
+    //
+    // the objective is stationary in the free derivatives, so its gradient w.r.t. the fixed ones is H * U at their rows
+    // and the one w.r.t. T_k is the partial derivative of the objective of segment k, dH_k/dT_k = E .* H_k / T_k
+    //
+    Eigen::MatrixXd HU;
+    MultiplyObjective(U, HU);
+
+    gradPos.resize(K + 1, U.cols());
+    for (int j = 0; j <= K; ++j) {
+        gradPos.row(j) = HU.row(j * S);
+    }
+
+    gradTime.resize(K);
+    for (int k = 0; k < K; ++k) {
+        const auto x = U.template middleRows<N>(k * S);
+        gradTime(k) = 0.50 * (E.cwiseProduct(H[k]) * x).cwiseProduct(x).sum() / time(k);
+    }
+}
+
+template <int COrder>
+void MinimumSnapTrajectory<COrder>::PropagateGradient(
+    const Eigen::MatrixXd &gradCoeffs,
+    const Eigen::VectorXd &gradTimePartial,
+    Eigen::MatrixXd &gradPos,
+    Eigen::VectorXd &gradTime
+) const {
+    const int K = time.size();
+    const int numDims = U.cols();
+    const Block &M0Inv = Kernel::GetM0Inverse();
+
+    //
+    // 1. from the coeffs of segment k, a = diag(T^-n) * M0^-1 * diag(T^c) * x_k, to its state x_k & time T_k:
+    //
+    Eigen::MatrixXd gradU = Eigen::MatrixXd::Zero(U.rows(), numDims);
+    gradTime = gradTimePartial;
+    for (int k = 0; k < K; ++k) {
+        const double T = time(k);
+        const State timeScalings = Kernel::GetTimeScalings(T);
+
+        State coeffScalings = State::Ones();
+        for (int n = 1; n < N; ++n) {
+            coeffScalings(n) = coeffScalings(n - 1) / T;
+        }
+
+        // derivatives of the scalings w.r.t. T:
+        State timeScalingsDerivative, coeffScalingsDerivative;
+        for (int n = 0; n < N; ++n) {
+            timeScalingsDerivative(n) = (n % S) * timeScalings(n) / T;
+            coeffScalingsDerivative(n) = -n * coeffScalings(n) / T;
+        }
+
+        for (int dim = 0; dim < numDims; ++dim) {
+            const State g = gradCoeffs.template block<1, N>(k, dim * N).transpose();
+            const State x = U.template block<N, 1>(k * S, dim);
+
+            gradU.template block<N, 1>(k * S, dim) += timeScalings.cwiseProduct(M0Inv.transpose() * g.cwiseProduct(coeffScalings));
+
+            gradTime(k) += g.dot(
+                coeffScalingsDerivative.cwiseProduct(M0Inv * x.cwiseProduct(timeScalings)) +
+                coeffScalings.cwiseProduct(M0Inv * x.cwiseProduct(timeScalingsDerivative))
+            );
+        }
+    }
+
+    //
+    // 2. adjoint of the free derivatives, the banded system with the free rows of the gradient as right-hand side:
+    //
+    Eigen::MatrixXd lambda = Eigen::MatrixXd::Zero(U.rows(), numDims);
+    if (K > 1) {
+        Eigen::MatrixXd R((K - 1) * F, numDims);
+        for (int j = 1; j < K; ++j) {
+            R.template middleRows<F>((j - 1) * F) = gradU.template middleRows<F>(j * S + 1);
+        }
+
+        SolveReduced(R);
+
+        for (int j = 1; j < K; ++j) {
+            lambda.template middleRows<F>(j * S + 1) = R.template middleRows<F>((j - 1) * F);
+        }
+    }
+
+    //
+    // 3. the free derivatives move with the fixed ones by -H_ff^-1 * H_fb and with T_k by -H_ff^-1 * (dH/dT_k * U)_f:
+    //
+    Eigen::MatrixXd HLambda;
+    MultiplyObjective(lambda, HLambda);
+
+    gradPos.resize(K + 1, numDims);
+    for (int j = 0; j <= K; ++j) {
+        gradPos.row(j) = gradU.row(j * S) - HLambda.row(j * S);
+    }
+
+    for (int k = 0; k < K; ++k) {
+        const auto x = U.template middleRows<N>(k * S);
+        const auto l = lambda.template middleRows<N>(k * S);
+        gradTime(k) -= (E.cwiseProduct(H[k]) * x).cwiseProduct(l).sum() / time(k);
+    }
+}
+
+template <int COrder>
+bool MinimumSnapTrajectory<COrder>::Factorize() {
+    const int K = time.size();
+
+    //
+    // per-segment blocks:
+    //
+    //     the derivative matrix M is block diagonal, the block of segment k maps its coeffs to its start & end state
+    //     as M_k = diag(1/T^c) * M0, so its inverse is M0^-1 * diag(T^c) in closed form and only M0, which does not
+    //     depend on the time allocation, is ever inverted. the objective block of segment k is w_k * Q0, hence the cost
+    //     of segment k in its start & end state x_k is x_k' * H_k * x_k with H_k = w_k * diag(T^c) * H0 * diag(T^c)
+    //     and H0 = M0^-T * Q0 * M0^-1. all of them are fixed-size
+    //
+    H.resize(K);
+    for (int k = 0; k < K; ++k) {
+        H[k] = Kernel::GetStateObjective(H0, tOrder, time(k));
+    }
+
+    //
+    // factorize the reduced problem:
+    //
+    //     the optimality conditions couple waypoint j only with its neighbours, so the reduced matrix is
+    //     block tridiagonal with F-by-F blocks, diagonal (H_{j-1}.C + H_j.A) and off-diagonal H_j.B in
+    //     H_k = [A, B; B', C]. block forward elimination keeps the decomposition of each Schur complement G_j
+    //     and W_j = G_j^-1 * B_j, any right-hand side is then solved in O(K)
+    //
+    decompositions.resize(std::max(K - 1, 0));
+    W.resize(F, std::max(K - 2, 0) * F);
+    for (int j = 1; j < K; ++j) {
+        Reduced G = H[j - 1].template block<F, F>(S + 1, S + 1) + H[j].template block<F, F>(1, 1);
+        if (j > 1) {
+            const Reduced BPrev = H[j - 1].template block<F, F>(1, S + 1);
+            G.noalias() -= BPrev.transpose() * W.template middleCols<F>((j - 2) * F);
+        }
+
+        Eigen::LLT<Reduced> &decomposition = decompositions[j - 1];
+        decomposition.compute(G);
+        if (decomposition.info() != Eigen::Success) {
+            ROS_WARN("[Minimum Snap, Analytic]: Failed to decompose the reduced system at waypoint %d.", j);
+            return false;
+        }
+
+        if (j < K - 1) {
+            W.template middleCols<F>((j - 1) * F) = decomposition.solve(H[j].template block<F, F>(1, S + 1));
+        }
+    }
+
+    return true;
+}
+
+template <int COrder>
+void MinimumSnapTrajectory<COrder>::Solve() {
+    const int K = time.size();
+    if (K < 2) {
+        return;
+    }
+
+    // gradient of the fixed latent variables, with the decision variables cleared:
+    for (int j = 1; j < K; ++j) {
+        U.template middleRows<F>(j * S + 1).setZero();
+    }
+
+    Eigen::MatrixXd HU;
+    MultiplyObjective(U, HU);
+
+    Eigen::MatrixXd R((K - 1) * F, U.cols());
+    for (int j = 1; j < K; ++j) {
+        R.template middleRows<F>((j - 1) * F) = -HU.template middleRows<F>(j * S + 1);
+    }
+
+    SolveReduced(R);
+
+    for (int j = 1; j < K; ++j) {
+        U.template middleRows<F>(j * S + 1) = R.template middleRows<F>((j - 1) * F);
+    }
+}
+
+template <int COrder>
+void MinimumSnapTrajectory<COrder>::SolveReduced(Eigen::MatrixXd &R) const {
+    const int K = time.size();
+
+    // forward elimination, Z_j = G_j^-1 * (Y_j - B_{j-1}' * Z_{j-1}):
+    for (int j = 1; j < K; ++j) {
+        auto Y = R.template middleRows<F>((j - 1) * F);
+        if (j > 1) {
+            const Reduced BPrev = H[j - 1].template block<F, F>(1, S + 1);
+            Y.noalias() -= BPrev.transpose() * R.template middleRows<F>((j - 2) * F);
+        }
+
+        decompositions[j - 1].solveInPlace(Y);
+    }
+
+    // back substitution, x_j = Z_j - W_j * x_{j+1}:
+    for (int j = K - 2; j >= 1; --j) {
+        R.template middleRows<F>((j - 1) * F).noalias() -= (
+            W.template middleCols<F>((j - 1) * F) * R.template middleRows<F>(j * F)
+        );
+    }
+}
+
+template <int COrder>
+void MinimumSnapTrajectory<COrder>::MultiplyObjective(const Eigen::MatrixXd &V, Eigen::MatrixXd &HV) const {
+    const int K = time.size();
+
+    HV = Eigen::MatrixXd::Zero(V.rows(), V.cols());
+    for (int k = 0; k < K; ++k) {
+        HV.template middleRows<N>(k * S).noalias() += H[k] * V.template middleRows<N>(k * S);
+    }
+}
+
+template class MinimumSnapTrajectory<2>;
+template class MinimumSnapTrajectory<3>;
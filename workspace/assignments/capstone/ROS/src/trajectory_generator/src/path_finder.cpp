@@ -381,4 +381,177 @@ std::vector<size_t> PathFinder::RefinePath(
   }
 
   return output;
-}
\ No newline at end of file
+}
+
+bool PathFinder::isFree(const Eigen::Vector3i &lower, const Eigen::Vector3i &upper) const {
+  for (int i = lower(0); i <= upper(0); ++i)
+    for (int j = lower(1); j <= upper(1); ++j)
+      for (int k = lower(2); k <= upper(2); ++k)
+        if (!isFree(i, j, k))
+          return false;
+
+  return true;
+}
+
+std::vector<size_t> PathFinder::GenerateCorridor(
+  const std::vector<Eigen::Vector3d> &path,
+  const std::vector<size_t> &input,
+  const int max_inflation,
+  Eigen::MatrixXd &corridor
+) {
+  std::vector<size_t> output = input;
+  std::vector<Eigen::Vector3i> lowers, uppers;
+  std::vector<bool> bounded;
+
+  //
+  // 1. seed each box with the bounding box of the A* path of its segment:
+  //
+  size_t segment_index{0};
+  while (segment_index + 1 < output.size()) {
+    const size_t begin = output[segment_index];
+    const size_t end = output[segment_index + 1];
+
+    Eigen::Vector3i lower = coord2gridIndex(path[begin]);
+    Eigen::Vector3i upper = lower;
+    for (size_t i = begin + 1; i <= end; ++i) {
+      const Eigen::Vector3i idx = coord2gridIndex(path[i]);
+      lower = lower.cwiseMin(idx);
+      upper = upper.cwiseMax(idx);
+    }
+
+    const bool is_free = isFree(lower, upper);
+    if (!is_free && end - begin > 1) {
+      // split at the mid waypoint, as RefinePath does, and try its first half again:
+      output.insert(output.begin() + segment_index + 1, (begin + end) >> 1);
+      continue;
+    }
+
+    lowers.push_back(lower);
+    uppers.push_back(upper);
+    bounded.push_back(is_free);
+
+    ++segment_index;
+  }
+
+  //
+  // 2. inflate each box face by face while the new slab of voxels is free:
+  //
+  const size_t K = lowers.size();
+  for (size_t k = 0; k < K; ++k) {
+    if (!bounded[k]) {
+      continue;
+    }
+
+    Eigen::Vector3i &lower = lowers[k];
+    Eigen::Vector3i &upper = uppers[k];
+
+    bool blocked[6] = {false, false, false, false, false, false};
+    for (int step = 0; step < max_inflation; ++step) {
+      bool is_inflated{false};
+
+      for (int face = 0; face < 6; ++face) {
+        if (blocked[face]) {
+          continue;
+        }
+
+        const int axis = face >> 1;
+        Eigen::Vector3i slab_lower = lower, slab_upper = upper;
+        if (face & 1) {
+          slab_lower(axis) = slab_upper(axis) = upper(axis) + 1;
+        } else {
+          slab_lower(axis) = slab_upper(axis) = lower(axis) - 1;
+        }
+
+        if (isFree(slab_lower, slab_upper)) {
+          lower = lower.cwiseMin(slab_lower);
+          upper = upper.cwiseMax(slab_upper);
+          is_inflated = true;
+        } else {
+          blocked[face] = true;
+        }
+      }
+
+      if (!is_inflated) {
+        break;
+      }
+    }
+  }
+
+  //
+  // 3. convert to coords, shrunk by a quarter voxel so the tolerance of the solver stays in free space:
+  //
+  const Eigen::Vector3d map_lower(gl_xl, gl_yl, gl_zl);
+  const Eigen::Vector3d map_upper(gl_xu, gl_yu, gl_zu);
+  const double margin = 0.25 * resolution;
+
+  corridor.resize(K, 6);
+  for (size_t k = 0; k < K; ++k) {
+    if (bounded[k]) {
+      const Eigen::Vector3d lower = map_lower + resolution * lowers[k].cast<double>();
+      const Eigen::Vector3d upper = map_lower + resolution * (uppers[k] + Eigen::Vector3i::Ones()).cast<double>();
+
+      corridor.block<1, 3>(k, 0) = (lower.array() + margin).matrix().transpose();
+      corridor.block<1, 3>(k, 3) = (upper.array() - margin).matrix().transpose();
+    } else {
+      // the map bounds the segment anyway, and unlike infinite bounds these reach the solver unclipped:
+      corridor.block<1, 3>(k, 0) = map_lower.transpose();
+      corridor.block<1, 3>(k, 3) = map_upper.transpose();
+    }
+  }
+
+  return output;
+}
+
+int PathFinder::DetectCollision(
+  const Eigen::MatrixXd &control_points,
+  const int max_subdivisions
+) {
+  const int K = control_points.rows();
+  const int M = control_points.cols() / 3;
+  if (M == 0) {
+    return PathFinder::NullIndex;
+  }
+
+  // pieces of the segment whose hull is still to be checked, with their num. of subdivisions:
+  std::vector<std::pair<Eigen::MatrixXd, int>> pieces;
+  Eigen::MatrixXd head(M, 3), tail(M, 3);
+
+  for (int k = 0; k < K; ++k) {
+    Eigen::MatrixXd points(M, 3);
+    for (int dim = 0; dim < 3; ++dim) {
+      points.col(dim) = control_points.block(k, dim * M, 1, M).transpose();
+    }
+
+    pieces.clear();
+    pieces.emplace_back(points, 0);
+    while (!pieces.empty()) {
+      const int depth = pieces.back().second;
+      points.swap(pieces.back().first);
+      pieces.pop_back();
+
+      // the curve stays in the convex hull of its control points, hence in their bounding box:
+      const Eigen::Vector3d lower = points.colwise().minCoeff().transpose();
+      const Eigen::Vector3d upper = points.colwise().maxCoeff().transpose();
+      if (isFree(coord2gridIndex(lower), coord2gridIndex(upper))) {
+        continue;
+      }
+
+      if (depth == max_subdivisions) {
+        return k;
+      }
+
+      // halve the piece by de Casteljau, the hulls of the halves are tighter:
+      for (int i = 0; i < M; ++i) {
+        head.row(i) = points.row(0);
+        tail.row(M - 1 - i) = points.row(M - 1 - i);
+        for (int j = 0; j < M - 1 - i; ++j) {
+          points.row(j) = 0.5 * (points.row(j) + points.row(j + 1));
+        }
+      }
+      pieces.emplace_back(head, depth + 1);
+      pieces.emplace_back(tail, depth + 1);
+    }
+  }
+
+  return PathFinder::NullIndex;
+}
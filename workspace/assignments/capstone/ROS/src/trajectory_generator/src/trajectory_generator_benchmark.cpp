@@ -0,0 +1,34 @@
+#include "trajectory_optimizer.hpp"
+#include "trajectory_benchmark.hpp"
+
+//
+// standalone benchmark of GenerateTrajectory with a cold numeric session, see trajectory_benchmark.hpp for the CSV
+// it writes:
+//
+//     rosrun trajectory_generator trajectory_generator_benchmark [output.csv] [num_trials] [max_segments] [seed]
+//
+// the coeffs are in real time
+//
+
+int main(int argc, char** argv)
+{
+    return trajectory_benchmark::Run(
+        argc, argv, "GenerateTrajectory", trajectory_benchmark::CoeffsTime::Real,
+        [](
+            const trajectory_benchmark::Method method,
+            const int tOrder,
+            const int cOrder,
+            const Eigen::MatrixXd &Pos,
+            const Eigen::MatrixXd &Vel,
+            const Eigen::MatrixXd &Acc,
+            const Eigen::VectorXd &Time
+        ) {
+            return TrajectoryOptimizer::GenerateTrajectory(
+                tOrder, cOrder, Pos, Vel, Acc, Time,
+                method == trajectory_benchmark::Method::Numeric ?
+                TrajectoryOptimizer::Solver::Numeric :
+                TrajectoryOptimizer::Solver::Analytic
+            );
+        }
+    );
+}
@@ -23,6 +23,7 @@
 #include "path_finder.hpp"
 #include "backward.hpp"
 #include "trajectory_optimizer.hpp"
+#include "trajectory_feasibility.hpp"
 
 using namespace std;
 using namespace Eigen;
@@ -33,6 +34,8 @@ PathFinder *_path_finder = new PathFinder();
 // Set the obstacle map
 std::string _map_frame_name;
 double _resolution, _inv_resolution, _path_resolution, _time_resolution;
+bool _collision_convex_hull;
+int _collision_max_subdivisions;
 double _x_size, _y_size, _z_size;
 Vector3d _map_lower, _map_upper;
 int _max_x_id, _max_y_id, _max_z_id;
@@ -41,6 +44,13 @@ int _max_x_id, _max_y_id, _max_z_id;
 double _vis_traj_width;
 double _Vel, _Acc;
 int _t_order, _c_order, _min_order;
+std::string _solution_method_spec;
+TrajectoryOptimizer::Solver _solution_method;
+bool _corridor_enable;
+int _corridor_max_inflation, _corridor_num_samples;
+double _time_weight;
+int _time_max_iterations;
+int _feasibility_max_iterations;
 
 // ros related
 ros::Subscriber _map_sub, _pts_sub, _odom_sub;
@@ -51,6 +61,8 @@ Vector3d odom_pos, odom_vel, source_pos, target_pos, start_vel;
 int _poly_num1D;
 MatrixXd _polyCoeff;
 VectorXd _polyTime;
+// numeric solver kept across the refinements of one path:
+TrajectoryOptimizer::NumericSession _numeric_session;
 double time_duration;
 ros::Time time_traj_start;
 bool has_odom = false;
@@ -79,7 +91,7 @@ void VisualizeWaypoints(
 void VisualizeTrajectory(const Eigen::MatrixXd &polyCoeff, const Eigen::VectorXd &time);
 void PublishTrajectory(const Eigen::MatrixXd &polyCoeff, const Eigen::VectorXd &time);
 
-void OptimizeTrajectory(const Eigen::MatrixXd &waypoints);
+void OptimizeTrajectory(const Eigen::MatrixXd &waypoints, const Eigen::MatrixXd &corridor);
 void OdometryCB(const nav_msgs::Odometry::ConstPtr &odom);
 void rcvWaypointsCallback(const nav_msgs::Path &wp);
 void PointCloudCB(const sensor_msgs::PointCloud2 &pointcloud_map);
@@ -255,6 +267,9 @@ bool GenerateTrajectory() {
   // STEP 2: simplify path with RDP:
   auto critical_waypoint_indices = _path_finder->SimplifyPath(waypoints, _path_resolution);
 
+  // the refinements below only insert waypoints, the solver starts cold for a new path:
+  _numeric_session.Reset();
+
   int unsafe_segment_index{PathFinder::NullIndex};
   do {
     // handle collision: add mid waypoint from A* in the hope that it could resolve collision
@@ -279,7 +294,15 @@ bool GenerateTrajectory() {
       }
     }
 
-    // STEP 3: optimize trajectory with minimum-snap piecewise monomial trajectory
+    // STEP 3: generate safe flight corridor, segments which can not be boxed are split first
+    Eigen::MatrixXd corridor;
+    if (_corridor_enable) {
+      critical_waypoint_indices = _path_finder->GenerateCorridor(
+        waypoints, critical_waypoint_indices, _corridor_max_inflation, corridor
+      );
+    }
+
+    // STEP 4: optimize trajectory with minimum-snap piecewise monomial trajectory
     const auto N = critical_waypoint_indices.size();
     Eigen::MatrixXd critical_waypoints = Eigen::MatrixXd::Zero(N, 3);
 
@@ -287,18 +310,25 @@ bool GenerateTrajectory() {
       critical_waypoints.row(n) = waypoints[critical_waypoint_indices[n]];
     }
 
-    OptimizeTrajectory(critical_waypoints);
+    OptimizeTrajectory(critical_waypoints, corridor);
     time_duration = _polyTime.sum();
 
-    // STEP 4: visulize path and trajectory
+    // STEP 5: visulize path and trajectory
     VisualizeWaypoints(waypoints, critical_waypoint_indices);
     VisualizeTrajectory(_polyCoeff, _polyTime);
 
-    // STEP 5: do collision detection:
-    unsafe_segment_index = _path_finder->DetectCollision(
-      _polyCoeff, _polyTime, _time_resolution, 
-      &TrajectoryOptimizer::GetPos
-    );
+    // STEP 6: do collision detection, by the convex hulls of the Bezier curves or at samples:
+    if (_collision_convex_hull) {
+      unsafe_segment_index = _path_finder->DetectCollision(
+        TrajectoryOptimizer::GetControlPoints(_polyCoeff, _polyTime), 
+        _collision_max_subdivisions
+      );
+    } else {
+      unsafe_segment_index = _path_finder->DetectCollision(
+        _polyCoeff, _polyTime, _time_resolution, 
+        &TrajectoryOptimizer::GetPos
+      );
+    }
   } while (unsafe_segment_index != PathFinder::NullIndex);
 
   //
@@ -315,25 +345,61 @@ bool GenerateTrajectory() {
     return false;
 }
 
-void OptimizeTrajectory(const Eigen::MatrixXd &waypoints) {
+void OptimizeTrajectory(const Eigen::MatrixXd &waypoints, const Eigen::MatrixXd &corridor) {
   // if( !has_odom ) return;
   MatrixXd vel = MatrixXd::Zero(2, 3);
   MatrixXd acc = MatrixXd::Zero(2, 3);
 
   vel.row(0) = start_vel;
 
-  // STEP 3.1: allocate time to each trajectory segment
+  // STEP 4.1: allocate time to each trajectory segment
   _polyTime = _traj_optimizer->AllocateTimes(
     waypoints, vel, acc, 
     _Vel, _Acc
   );
 
-  // STEP 3.2: generate a minimum-jerk piecewise monomial trajectory
-  _polyCoeff = _traj_optimizer->GenerateTrajectory(
+  // trade the minimum snap objective off against the total time, starting from the heuristic allocation:
+  _polyTime = _traj_optimizer->OptimizeTimes(
     _t_order, _c_order, 
     waypoints, vel, acc, _polyTime,
-    TrajectoryOptimizer::Solver::Analytic
+    _time_weight, _time_max_iterations
   );
+
+  // STEP 4.2: generate a minimum-jerk piecewise monomial trajectory, in the corridor if there is one
+  auto generate_coeffs = [&]() {
+    _polyCoeff.resize(0, 0);
+    if (corridor.rows() > 0) {
+      _polyCoeff = _traj_optimizer->GenerateSafeTrajectory(
+        _t_order, _c_order, 
+        waypoints, vel, acc, _polyTime,
+        corridor, _corridor_num_samples, &_numeric_session
+      );
+    }
+
+    if (_polyCoeff.rows() == 0) {
+      _polyCoeff = _traj_optimizer->GenerateTrajectory(
+        _t_order, _c_order, 
+        waypoints, vel, acc, _polyTime,
+        _solution_method, &_numeric_session
+      );
+    }
+  };
+  generate_coeffs();
+
+  // STEP 4.3: stretch only the segments whose max. velocity or acceleration exceeds the limits, and regenerate
+  trajectory_feasibility::StretchToLimits(
+    _polyTime, _feasibility_max_iterations,
+    [&]() { return TrajectoryOptimizer::GetTimeStretches(_polyCoeff, _polyTime, _Vel, _Acc); },
+    generate_coeffs
+  );
+
+  if (corridor.rows() > 0 || _solution_method == TrajectoryOptimizer::Solver::Numeric) {
+    ROS_WARN(
+      "[Minimum Snap, Numeric]: %d OSQP iterations, %s start", 
+      _numeric_session.GetNumIterations(),
+      _numeric_session.IsWarmStarted() ? "warm" : "cold"
+    );
+  }
 }
 
 void PublishTrajectory(
@@ -603,6 +669,13 @@ int main(int argc, char **argv) {
   nh.param("planning/min_order", _min_order, 3);
   nh.param("planning/t_order", _t_order, 4);
   nh.param("planning/c_order", _c_order, 3);
+  nh.param("planning/solution_method", _solution_method_spec, std::string("analytic"));
+  nh.param("corridor/enable", _corridor_enable, true);
+  nh.param("corridor/max_inflation", _corridor_max_inflation, 10);
+  nh.param("corridor/num_samples", _corridor_num_samples, 0);
+  nh.param("time_allocation/weight", _time_weight, 0.0);
+  nh.param("time_allocation/max_iterations", _time_max_iterations, 20);
+  nh.param("feasibility/max_iterations", _feasibility_max_iterations, 5);
 
   nh.param("vis/vis_traj_width", _vis_traj_width, 0.15);
   nh.param("map_frame_name", _map_frame_name, std::string("world"));
@@ -612,6 +685,8 @@ int main(int argc, char **argv) {
   nh.param("map/z_size", _z_size, 5.0);
   nh.param("path/resolution", _path_resolution, 0.05);
   nh.param("collision_detection/resolution", _time_resolution, 0.05);
+  nh.param("collision_detection/convex_hull", _collision_convex_hull, true);
+  nh.param("collision_detection/max_subdivisions", _collision_max_subdivisions, 6);
   nh.param("replanning/thresh_replan", replan_thresh, -1.0);
   nh.param("replanning/thresh_no_replan", no_replan_thresh, -1.0);
 
@@ -621,6 +696,8 @@ int main(int argc, char **argv) {
   // set waypoint continuity constraint:
   _c_order = (_t_order - 1);
   _poly_num1D = TrajectoryOptimizer::GetNumCoeffs(_c_order);
+  // set solution method:
+  _solution_method = ((_solution_method_spec == "numeric") ? TrajectoryOptimizer::Solver::Numeric : TrajectoryOptimizer::Solver::Analytic);
 
   _exec_timer = nh.createTimer(ros::Duration(0.01), STMCB);
 
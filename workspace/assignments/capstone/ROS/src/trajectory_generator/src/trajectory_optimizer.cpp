@@ -1,4 +1,8 @@
 #include "trajectory_optimizer.hpp"
+#include "poly_kernel.hpp"
+#include "minimum_snap_trajectory.hpp"
+#include "trajectory_feasibility.hpp"
+#include "obvp_closed_form.hpp"
 
 #include <osqp++.h>
 
@@ -7,13 +11,73 @@
 #include <chrono>
 #include <string>
 #include <vector>
-#include <map>
 
-#include <unsupported/Eigen/Polynomials>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace {
+// num. of curvature pairs kept by L-BFGS in time allocation optimization:
+constexpr int TimesMemory{8};
+// max. change of log segment time per quasi-Newton step, so no segment time more than halves or doubles:
+constexpr double TimesMaxLogStep{0.6931471805599453};
+// max. num. of halvings in the backtracking line search:
+constexpr int TimesLineSearchSteps{10};
+// stop once a step decreases the objective by less than this fraction:
+constexpr double TimesRelativeTolerance{1e-4};
+
+/**
+  * @brief find the waypoint inserted into prevPos to get Pos
+  *
+  * @return index of the inserted waypoint in Pos, -1 if Pos is not prevPos with one intermediate waypoint inserted
+  */
+int FindInsertedWaypoint(const Eigen::MatrixXd &prevPos, const Eigen::MatrixXd &Pos) {
+    const int numWaypoints = prevPos.rows();
+    if (Pos.rows() != numWaypoints + 1 || Pos.cols() != prevPos.cols()) {
+        return -1;
+    }
+
+    // the first row which differs:
+    int inserted{0};
+    while (inserted < numWaypoints && Pos.row(inserted) == prevPos.row(inserted)) {
+        ++inserted;
+    }
+
+    // the start & goal are kept and the rest is shifted by one:
+    if (
+        inserted == 0 || inserted == numWaypoints ||
+        Pos.bottomRows(numWaypoints - inserted) != prevPos.bottomRows(numWaypoints - inserted)
+    ) {
+        return -1;
+    }
+
+    return inserted;
+}
+}
 
 TrajectoryOptimizer::TrajectoryOptimizer(){}
 TrajectoryOptimizer::~TrajectoryOptimizer(){}
 
+TrajectoryOptimizer::NumericSession::NumericSession(){}
+TrajectoryOptimizer::NumericSession::~NumericSession(){}
+
+void TrajectoryOptimizer::NumericSession::Reset() {
+    solver.reset();
+
+    tOrder = cOrder = -1;
+    numSegments = numConstraints = numDims = 0;
+
+    Pos.resize(0, 0);
+    primal.resize(0, 0);
+    dual.resize(0, 0);
+
+    numIterations = 0;
+    isWarmStarted = false;
+}
+
 /**
   * @brief get partial factorial generated in derivative computing
   *
@@ -80,6 +144,116 @@ Eigen::Vector3d TrajectoryOptimizer::GetVel(const Eigen::MatrixXd &coeffs, const
     return vel; 
 }
 
+/**
+  * @brief get the control points of the Bezier curves of the [d]th derivative of the trajectory
+  *
+  * @param[in] coeffs polynomial coefficients, K-by-(3 * N)
+  * @param[in] time allocated time for each trajectory segment, K-by-1
+  * @param[in] d derivative order, in [0, N)
+  *
+  * @return control points of each segment, K-by-(3 * (N - d))
+  */
+Eigen::MatrixXd TrajectoryOptimizer::GetControlPoints(const Eigen::MatrixXd &coeffs, const Eigen::VectorXd &time, const int d) {
+    const int N = coeffs.cols() / 3;
+    const int K = time.size();
+    // num. of control points of the [d]th derivative:
+    const int M = N - d;
+
+    if (d < 0 || M <= 0) {
+        return Eigen::MatrixXd::Zero(K, 0);
+    }
+
+    //
+    // 1. the basis change from the coeffs in normalized time s = t / T to the control points:
+    //
+    //     s^n in the Bernstein basis of degree N - 1 gives control point i the weight C(i, n) / C(N - 1, n) for n <= i
+    //
+    Eigen::MatrixXd BernsteinTransform = Eigen::MatrixXd::Zero(N, N);
+    for (int n = 0; n < N; ++n) {
+        for (int i = n; i < N; ++i) {
+            BernsteinTransform(i, n) = GetFactorial(i, n) / GetFactorial(N - 1, n);
+        }
+    }
+
+    Eigen::MatrixXd result(K, 3 * M);
+    Eigen::VectorXd normalizedCoeffs(N), controlPoints(N);
+    for (int k = 0; k < K; ++k) {
+        for (int dim = 0; dim < 3; ++dim) {
+            double timePower{1.0};
+            for (int n = 0; n < N; ++n) {
+                normalizedCoeffs(n) = coeffs(k, dim * N + n) * timePower;
+                timePower *= time(k);
+            }
+            controlPoints.noalias() = BernsteinTransform * normalizedCoeffs;
+
+            // 2. the derivative of a Bezier curve of degree m has the control points m * (c_{i+1} - c_i), in t = T * s:
+            for (int m = N - 1; m > N - 1 - d; --m) {
+                for (int i = 0; i < m; ++i) {
+                    controlPoints(i) = m * (controlPoints(i + 1) - controlPoints(i)) / time(k);
+                }
+            }
+
+            result.block(k, dim * M, 1, M) = controlPoints.head(M).transpose();
+        }
+    }
+
+    return result;
+}
+
+/**
+  * @brief get the max. norm of the [d]th derivative of a trajectory segment
+  *
+  * @param[in] coeffs polynomial coefficients, K-by-(3 * N)
+  * @param[in] k trajectory segment index
+  * @param[in] T allocated time of the segment
+  * @param[in] d derivative order
+  *
+  * @return max. of the norm over [0, T]
+  */
+double TrajectoryOptimizer::GetMaxDerivativeNorm(const Eigen::MatrixXd &coeffs, const int k, const double T, const int d) {
+    const int N = coeffs.cols() / 3;
+    // num. of coeffs of the [d]th derivative:
+    const int M = N - d;
+
+    if (d < 0 || M <= 0) {
+        return 0.0;
+    }
+
+    // [d]th derivative in normalized time s = t / T, which keeps the coeffs of comparable magnitude for the root isolation:
+    Eigen::MatrixXd derivative(M, 3);
+    for (int dim = 0; dim < 3; ++dim) {
+        double timePower{1.0};
+        for (int n = d; n < N; ++n) {
+            derivative(n - d, dim) = coeffs(k, dim * N + n) * GetFactorial(n, d) * timePower;
+            timePower *= T;
+        }
+    }
+
+    return trajectory_feasibility::GetMaxNorm(derivative);
+}
+
+/**
+  * @brief get the factors which stretch the segments violating the velocity or acceleration limit
+  *
+  * @param[in] coeffs polynomial coefficients, K-by-(3 * N)
+  * @param[in] time allocated time for each trajectory segment, K-by-1
+  * @param[in] velLimit max. velocity
+  * @param[in] accLimit max. acceleration
+  *
+  * @return stretch of each segment, 1.0 if it is feasible, otherwise its ratio to the limits with a small margin
+  */
+Eigen::VectorXd TrajectoryOptimizer::GetTimeStretches(
+    const Eigen::MatrixXd &coeffs,
+    const Eigen::VectorXd &time,
+    const double velLimit,
+    const double accLimit
+) {
+    return trajectory_feasibility::GetTimeStretches(
+        time.size(), velLimit, accLimit,
+        [&](const int k, const int d) { return GetMaxDerivativeNorm(coeffs, k, time(k), d); }
+    );
+}
+
 /**
 * @brief allocate traversal time for each trajectory segment
 *
@@ -120,6 +294,47 @@ Eigen::VectorXd TrajectoryOptimizer::AllocateTimes(
     return time;
 }
 
+/**
+ * @brief optimize the time allocation for the minimum snap objective plus weighted total time
+ *
+ * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
+ * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
+ * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+ * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+ * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
+ * @param[in] Time initial time allocations, e.g. from AllocateTimes, K-by-1
+ * @param[in] timeWeight weight of the total time
+ * @param[in] maxIterations max. num. of quasi-Newton steps
+ *
+ * @return optimized time allocations, K-by-1
+ */
+Eigen::VectorXd TrajectoryOptimizer::OptimizeTimes(
+    const int tOrder,
+    const int cOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const double timeWeight,
+    const int maxIterations
+) {
+    // a single segment is solved as OBVP, which is not the objective optimized here:
+    if (Time.size() < 2 || timeWeight <= 0.0 || maxIterations <= 0) {
+        return Time;
+    }
+
+    switch (cOrder) {
+        case 2:
+            return DoTimesOptimization<2>(tOrder, Pos, Vel, Acc, Time, timeWeight, maxIterations);
+        case 3:
+            return DoTimesOptimization<3>(tOrder, Pos, Vel, Acc, Time, timeWeight, maxIterations);
+        default:
+            // defaults to the initial time allocations:
+            ROS_WARN("[Time Allocation]: cOrder %d is not supported, only 2 & 3 are.", cOrder);
+            return Time;
+    }
+}
+
 /**
  * @brief generate minimum snap trajectory through numeric method with OSQP C++
  *
@@ -130,6 +345,7 @@ Eigen::VectorXd TrajectoryOptimizer::AllocateTimes(
  * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
  * @param[in] Time pre-computed time allocations, K-by-1
  * @param[in] method solution method, defaults to Analytic
+ * @param[in,out] session numeric solver session reused across calls, only used by Numeric, may be nullptr
  *
  * @return polynomial coeffs of generated trajectory, K-by-(D * N)
  * @note the pre-assumption is no allocated segment time in Time is 0
@@ -141,7 +357,8 @@ Eigen::MatrixXd TrajectoryOptimizer::GenerateTrajectory(
     const Eigen::MatrixXd &Vel,
     const Eigen::MatrixXd &Acc,
     const Eigen::VectorXd &Time,
-    const TrajectoryOptimizer::Solver method
+    const TrajectoryOptimizer::Solver method,
+    TrajectoryOptimizer::NumericSession *session
 ) {
     // tic:
     const auto tStart = std::chrono::high_resolution_clock::now();
@@ -154,36 +371,34 @@ Eigen::MatrixXd TrajectoryOptimizer::GenerateTrajectory(
         result = DoOBVPTrajectoryGeneration(tOrder, Pos, Vel, Acc, Time);
     } else {
         ROS_WARN("\t[TrajectoryOptimizer::GenerateTrajectory] piecewise monomial minimum jerk");
-        const int N = GetNumCoeffs(cOrder);
-        
-        // init:
-        result = Eigen::MatrixXd::Zero(K, 3 * N);
-
-        for (int i = 0; i < Pos.cols(); ++i) {
-            switch (method) {
-                case TrajectoryOptimizer::Solver::Numeric:
-                    result.block(0, i*N, K, N) = DoTrajectoryGenerationNumerically(
-                        tOrder,
-                        cOrder,
-                        Pos.col(i),
-                        Vel.col(i),
-                        Acc.col(i),
-                        Time
-                    );
-                    break;
-                case TrajectoryOptimizer::Solver::Analytic:
-                    result.block(0, i*N, K, N) = DoTrajectoryGenerationAnalytically(
-                        tOrder,
-                        cOrder,
-                        Pos.col(i),
-                        Vel.col(i),
-                        Acc.col(i),
-                        Time
-                    );
-                    break;
-                default:
-                    break;
-            }
+        // all dimensions share the time allocation, so they are solved together:
+        switch (method) {
+            case TrajectoryOptimizer::Solver::Numeric:
+                result = DoTrajectoryGenerationNumerically(
+                    tOrder,
+                    cOrder,
+                    Pos,
+                    Vel,
+                    Acc,
+                    Time,
+                    Eigen::MatrixXd(),
+                    0,
+                    session
+                );
+                break;
+            case TrajectoryOptimizer::Solver::Analytic:
+                result = DoTrajectoryGenerationAnalytically(
+                    tOrder,
+                    cOrder,
+                    Pos,
+                    Vel,
+                    Acc,
+                    Time
+                );
+                break;
+            default:
+                result = Eigen::MatrixXd::Zero(K, Pos.cols() * GetNumCoeffs(cOrder));
+                break;
         }
     }
 
@@ -201,6 +416,73 @@ Eigen::MatrixXd TrajectoryOptimizer::GenerateTrajectory(
     return result;
 }
 
+/**
+ * @brief generate minimum snap trajectory which stays in a safe flight corridor
+ *
+ * @param[in] tOrder the L2-norm of [tOrder]th derivative of the target trajectory will be used as objective function
+ * @param[in] cOrder continuity constraints, the target trajectory should be [cOrder]th continuous at intermediate waypoints
+ * @param[in] Pos equality constraints, the target trajectory should pass all the waypoints, (K + 1)-by-D
+ * @param[in] Vel equality constraints, boundary(start & goal) velocity specifications, 2-by-D
+ * @param[in] Acc equality constraints, boundary(start & goal) acceleration specifications, 2-by-D
+ * @param[in] Time pre-computed time allocations, K-by-1
+ * @param[in] Corridor inequality constraints, axis-aligned box of each segment, K-by-(2 * D) as lower & upper bounds
+ * @param[in] numSamples num. of evenly spaced samples within each segment which should stay in its box,
+ *                       0 to keep the control points of its Bezier curve in the box instead
+ * @param[in,out] session numeric solver session reused across calls, may be nullptr
+ *
+ * @return polynomial coeffs of generated trajectory, K-by-(D * N), empty if none stays in the corridor
+ * @note the pre-assumption is no allocated segment time in Time is 0
+ */
+Eigen::MatrixXd TrajectoryOptimizer::GenerateSafeTrajectory(
+    const int tOrder,
+    const int cOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const Eigen::MatrixXd &Corridor,
+    const int numSamples,
+    TrajectoryOptimizer::NumericSession *session
+) {
+    // tic:
+    const auto tStart = std::chrono::high_resolution_clock::now();
+
+    const int K = Time.size();
+    if (Corridor.rows() != K || Corridor.cols() != 2 * Pos.cols() || numSamples < 0) {
+        ROS_WARN(
+            "[TrajectoryOptimizer::GenerateSafeTrajectory] corridor should be %d-by-%d with non-negative num. of samples", 
+            K, 2 * static_cast<int>(Pos.cols())
+        );
+        return Eigen::MatrixXd();
+    }
+
+    // the boxes are inequality constraints, so only the numeric method applies:
+    Eigen::MatrixXd result = DoTrajectoryGenerationNumerically(
+        tOrder,
+        cOrder,
+        Pos,
+        Vel,
+        Acc,
+        Time,
+        Corridor,
+        numSamples,
+        session
+    );
+
+    // toc:
+    const auto tEnd = std::chrono::high_resolution_clock::now();
+
+    // measure elapsed time:
+    std::chrono::duration<double, std::milli> durationMs = tEnd - tStart;
+
+    ROS_WARN(
+        "[TrajectoryOptimizer::GenerateSafeTrajectory] time elapsed %.2f ms", 
+        durationMs.count()
+    );
+
+    return result;
+}
+
 /**
   * @brief evaluate d-th order derivative of trajectory polynomial at time t
   *
@@ -228,104 +510,66 @@ double TrajectoryOptimizer::EvaluatePoly(const Eigen::VectorXd &coeffs, const in
     return result;
 }
 
+/**
+  * @brief find real roots of depressed quartic x^4 + p*x^2 + q*x + r
+  *
+  * @param[in] p quadratic coeff
+  * @param[in] q linear coeff
+  * @param[in] r constant coeff
+  * @param[out] roots real roots, polished by Newton iterations
+  *
+  * @return num. of real roots
+  */
+int TrajectoryOptimizer::SolveDepressedQuartic(const double p, const double q, const double r, double roots[4]) {
+    return obvp_closed_form::SolveDepressedQuartic(p, q, r, roots);
+}
+
+/**
+  * @brief solve the time-optimal OBVP of the double integrator, J = T + integral of |a|^2, in closed form
+  *
+  * @param[in] a |v0|^2 + v0.v1 + |v1|^2
+  * @param[in] b dp.(v0 + v1)
+  * @param[in] c |dp|^2
+  * @param[out] optimalTime optimal traversal time, 0.0 if there is no positive one
+  *
+  * @return optimal cost, infinity if there is no positive traversal time
+  */
+double TrajectoryOptimizer::SolveOBVP(const double a, const double b, const double c, double &optimalTime) {
+    return obvp_closed_form::Solve(a, b, c, Epsilon, optimalTime);
+}
+
+/**
+  * @brief batched version of SolveOBVP over coefficient arrays
+  */
+void TrajectoryOptimizer::SolveOBVP(const int num, const double *a, const double *b, const double *c, double *cost, double *optimalTime) {
+    double T;
+    for (int i = 0; i < num; ++i) {
+        cost[i] = SolveOBVP(a[i], b[i], c[i], T);
+        if (optimalTime != nullptr) {
+            optimalTime[i] = T;
+        }
+    }
+}
+
 Eigen::VectorXd TrajectoryOptimizer::DoOBVPTimesAllocation(
     const Eigen::MatrixXd &Pos,
     const Eigen::MatrixXd &Vel,
     const Eigen::MatrixXd &Acc
 ) {
-    double optimal_cost{std::numeric_limits<double>::max()}; 
-    double optimal_time{DefaultTime};
-
-    // init:
-    const auto &pos_x_str = Pos(0, 0);
-    const auto &pos_y_str = Pos(0, 1);
-    const auto &pos_z_str = Pos(0, 2);
-
-    const auto pos_x_str_squared = pos_x_str * pos_x_str;
-    const auto pos_y_str_squared = pos_y_str * pos_y_str;
-    const auto pos_z_str_squared = pos_z_str * pos_z_str;
-
-    const auto &vel_x_str = Vel(0, 0);
-    const auto &vel_y_str = Vel(0, 1);
-    const auto &vel_z_str = Vel(0, 2);
-
-    const auto vel_x_str_squared = vel_x_str * vel_x_str;
-    const auto vel_y_str_squared = vel_y_str * vel_y_str;
-    const auto vel_z_str_squared = vel_z_str * vel_z_str;
-
-    const auto &pos_x_end = Pos(1, 0);
-    const auto &pos_y_end = Pos(1, 1);
-    const auto &pos_z_end = Pos(1, 2);
-
-    const auto pos_x_end_squared = pos_x_end * pos_x_end;
-    const auto pos_y_end_squared = pos_y_end * pos_y_end;
-    const auto pos_z_end_squared = pos_z_end * pos_z_end;
-
-    const auto &vel_x_end = Vel(1, 0);
-    const auto &vel_y_end = Vel(1, 1);
-    const auto &vel_z_end = Vel(1, 2);
-
-    const auto vel_x_end_squared = vel_x_end * vel_x_end;
-    const auto vel_y_end_squared = vel_y_end * vel_y_end;
-    const auto vel_z_end_squared = vel_z_end * vel_z_end;
-
-    // define cost function:
-    auto EvaluateCost = [&](const double T) {
-        auto result = (
-            T * (
-                T*(
-                    T + 
-                    (4*vel_x_end_squared + 4*vel_x_end*vel_x_str + 4*vel_x_str_squared + 4*vel_y_end_squared + 4*vel_y_end*vel_y_str + 4*vel_y_str_squared + 4*vel_z_end_squared + 4*vel_z_end*vel_z_str + 4*vel_z_str_squared)
-                ) + 
-                (-12*pos_x_end*vel_x_end - 12*pos_x_end*vel_x_str + 12*pos_x_str*vel_x_end + 12*pos_x_str*vel_x_str - 12*pos_y_end*vel_y_end - 12*pos_y_end*vel_y_str + 12*pos_y_str*vel_y_end + 12*pos_y_str*vel_y_str - 12*pos_z_end*vel_z_end - 12*pos_z_end*vel_z_str + 12*pos_z_str*vel_z_end + 12*pos_z_str*vel_z_str)
-            ) +  
-            (12*pos_x_end_squared - 24*pos_x_end*pos_x_str + 12*pos_x_str_squared + 12*pos_y_end_squared - 24*pos_y_end*pos_y_str + 12*pos_y_str_squared + 12*pos_z_end_squared - 24*pos_z_end*pos_z_str + 12*pos_z_str_squared)
-        );
+    const Eigen::Vector3d deltaPos = (Pos.row(1) - Pos.row(0)).transpose();
+    const Eigen::Vector3d velStr = Vel.row(0).transpose();
+    const Eigen::Vector3d velEnd = Vel.row(1).transpose();
 
-        return result / std::pow(T, 3);
-    };
-    
-    // identify where the derivative of cost function equals to 0:
-    Eigen::VectorXd coeffs(7);
-
-    coeffs << 0.0,
-           // 1st:
-              0.0,
-           // 2nd:
-              -36*pos_x_end_squared + 72*pos_x_end*pos_x_str - 36*pos_x_str_squared - 36*pos_y_end_squared + 72*pos_y_end*pos_y_str - 36*pos_y_str_squared - 36*pos_z_end_squared + 72*pos_z_end*pos_z_str - 36*pos_z_str_squared,
-           // 3rd:
-              24*pos_x_end*vel_x_end + 24*pos_x_end*vel_x_str - 24*pos_x_str*vel_x_end - 24*pos_x_str*vel_x_str + 24*pos_y_end*vel_y_end + 24*pos_y_end*vel_y_str - 24*pos_y_str*vel_y_end - 24*pos_y_str*vel_y_str + 24*pos_z_end*vel_z_end + 24*pos_z_end*vel_z_str - 24*pos_z_str*vel_z_end - 24*pos_z_str*vel_z_str,
-           // 4th:
-              -4*vel_x_end_squared - 4*vel_x_end*vel_x_str - 4*vel_x_str_squared - 4*vel_y_end_squared - 4*vel_y_end*vel_y_str - 4*vel_y_str_squared - 4*vel_z_end_squared - 4*vel_z_end*vel_z_str - 4*vel_z_str_squared,
-           // 5th:
-              0.0,
-           // 6th:
-              1.0;
-
-    Eigen::PolynomialSolver<double, Eigen::Dynamic> solver;
-    solver.compute(coeffs);
-
-    const Eigen::PolynomialSolver<double, Eigen::Dynamic>::RootsType &r = solver.roots();
-    
-    for (size_t i = 0; i < 6; ++i) {
-        if (
-            // positive real root only:
-            (r(i).real() > Epsilon) &&
-            (std::abs(r(i).imag()) < Epsilon)
-        ) {            
-            double curr_cost = EvaluateCost(r(i).real());
-
-            if (curr_cost < optimal_cost) {
-                optimal_cost = curr_cost;
-                optimal_time = r(i).real();
-            }
-        }
-        
-    }
+    const double a = velStr.squaredNorm() + velStr.dot(velEnd) + velEnd.squaredNorm();
+    const double b = deltaPos.dot(velStr + velEnd);
+    const double c = deltaPos.squaredNorm();
+
+    double optimalTime;
+    const double optimalCost = SolveOBVP(a, b, c, optimalTime);
 
     // format output:
     Eigen::VectorXd time = Eigen::VectorXd::Ones(1);
-    time(0) = optimal_time;
+    time(0) = std::isinf(optimalCost) ? DefaultTime : optimalTime;
 
     return time;
 }
@@ -521,33 +765,78 @@ Eigen::MatrixXd TrajectoryOptimizer::DoOBVPTrajectoryGeneration(
 Eigen::MatrixXd TrajectoryOptimizer::DoTrajectoryGenerationNumerically(
     const int tOrder,       
     const int cOrder,    
-    const Eigen::VectorXd &Pos,
-    const Eigen::VectorXd &Vel,
-    const Eigen::VectorXd &Acc,
-    const Eigen::VectorXd &Time
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const Eigen::MatrixXd &Corridor,
+    const int numSamples,
+    TrajectoryOptimizer::NumericSession *session
 ) {
+    switch (cOrder) {
+        case 2:
+            return DoTrajectoryGenerationNumerically<2>(tOrder, Pos, Vel, Acc, Time, Corridor, numSamples, session);
+        case 3:
+            return DoTrajectoryGenerationNumerically<3>(tOrder, Pos, Vel, Acc, Time, Corridor, numSamples, session);
+        default:
+            // defaults to Eigen::MatrixXd::Zero():
+            ROS_WARN("[Minimum Snap, Numeric]: cOrder %d is not supported, only 2 & 3 are.", cOrder);
+            return Eigen::MatrixXd::Zero(Time.size(), Pos.cols() * GetNumCoeffs(cOrder));
+    }
+}
+
+template <int COrder>
+Eigen::MatrixXd TrajectoryOptimizer::DoTrajectoryGenerationNumerically(
+    const int tOrder,       
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const Eigen::MatrixXd &Corridor,
+    const int numSamples,
+    TrajectoryOptimizer::NumericSession *session
+) {
+    using Kernel = PolyKernel<COrder>;
+    using Block = typename Kernel::Block;
+    using State = typename Kernel::State;
+
     // num. of polynomial coeffs:
-    const auto N = GetNumCoeffs(cOrder);
+    constexpr int N = Kernel::N;
+    // num. of derivatives constrained at each waypoint:
+    constexpr int S = Kernel::S;
     // num. of trajectory segments:
-    const auto K = Time.size();
+    const int K = Time.size();
     // dim of flattened output:
-    const auto D = K * N;
+    const int D = K * N;
+    // num. of samples kept in the corridor box of their segment, or the control points of the Bezier curves:
+    const bool isHullConstrained = (numSamples == 0);
+    const int numCorridorSamples = (Corridor.size() > 0 ? K * (isHullConstrained ? N : numSamples) : 0);
     // num. of inequality constraints:
-    const auto C = (
+    const int C = (
         // 1. boundary value equality constraints:
         N + 
         // 2. intermediate waypoint passing equality constraints:
         (K - 1) + 
         // 3. intermediate waypoint continuity constaints:
-        (K - 1) * (cOrder + 1)
+        (K - 1) * S +
+        // 4. safe flight corridor inequality constraints:
+        numCorridorSamples
     );
+    // num. of dimensions:
+    const int numDims = Pos.cols();
 
     //
     // init output:
     //
-    //     the trajectory segment k is defined by result(k, 0) + t*(result(k, 1) + ...)
+    //     the trajectory segment k of dimension dim is defined by result(k, dim*N) + t*(result(k, dim*N + 1) + ...)
     // 
-    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(K, N);
+    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(K, numDims * N);
+
+    if (tOrder < 0 || tOrder >= N) {
+        // defaults to Eigen::MatrixXd::Zero():
+        ROS_WARN("[Minimum Snap, Numeric]: tOrder %d is out of range for %d coeffs.", tOrder, N);
+        return result;
+    }
 
     //
     // problem definition:
@@ -570,42 +859,12 @@ Eigen::MatrixXd TrajectoryOptimizer::DoTrajectoryGenerationNumerically(
     // 1. init:
     Eigen::SparseMatrix<double> P(D, D);
     std::vector<Eigen::Triplet<double>> PTriplets;
+    PTriplets.reserve(K * (N - tOrder) * (N - tOrder));
     
-    // 2. cache results for objective matrix construction:
-    
-    // 2.a time power
-    Eigen::VectorXd PTimePower = Eigen::VectorXd::Ones(K);
-    for (int c = 1; c < tOrder; ++c) {
-        PTimePower = PTimePower.cwiseProduct(Time);
-    }
-    
-    // 2.b factorial
-    std::map<int, double> PFactorial;
-    for (int n = tOrder; n < N; ++n) {
-        PFactorial.insert(
-            {n, GetFactorial(n, tOrder)}
-        );
-    }
-
-    // 3. populate PTriplets:
-    for (int k = 0; k < K; ++k) {
-        const auto currentSegmentIdxOffset = k * N;
-
-        for (int m = tOrder; m < N; ++m) {
-            for (int n = tOrder; n < N; ++n) {
-                PTriplets.emplace_back(
-                    currentSegmentIdxOffset + m,
-                    currentSegmentIdxOffset + n,
-                    Time(k)*PFactorial[m]*PFactorial[n]/(
-                        (m + n - (tOrder << 1) + 1) *
-                        PTimePower(k) * PTimePower(k)
-                    )
-                );
-            }
-        }
-    }
+    // 2. populate PTriplets, the objective of segment k is the one with unit time scaled by its weight:
+    Kernel::AddObjectiveTriplets(tOrder, Time, PTriplets);
 
-    // 4. populate P:
+    // 3. populate P:
     P.setFromTriplets(std::begin(PTriplets),std::end(PTriplets));
 
     //
@@ -613,165 +872,214 @@ Eigen::MatrixXd TrajectoryOptimizer::DoTrajectoryGenerationNumerically(
     //
     // 1. init:
     Eigen::SparseMatrix<double> A(C, D);
-    Eigen::VectorXd b = Eigen::VectorXd::Zero(C);
+    // one column of bounds per dimension, lower & upper only differ for the corridor:
+    Eigen::MatrixXd b = Eigen::MatrixXd::Zero(C, numDims);
+    Eigen::MatrixXd bUpper;
     std::vector<Eigen::Triplet<double>> ATriplets;
+    ATriplets.reserve(S * (N + 1) + (K - 1) * (S * (N + 1) + 1) + numCorridorSamples * N);
 
-    // 2. cache results for constraint matrix construction:
-    std::map<int, Eigen::VectorXd> ATimePower;
-    std::map<int, double> AFactorial;
-
-    // 2.a init:
-    ATimePower.insert(
-        {0, Eigen::VectorXd::Ones(K)}
-    );
-    
-    auto GetAFactorialKey = [&](const int n, const int d) {
-        return d * N + n;
-    };
-    for (int n = 0; n < N; ++n) {
-        AFactorial.insert(
-            {GetAFactorialKey(n, 0), 1.0}
-        );
-    }
-
-    for (int c = 1; c <= cOrder; ++c) {
-        // 2.b time power
-        ATimePower.insert(
-            {c, ATimePower[c - 1].cwiseProduct(Time)}
-        );
-
-        // 2.c factorial
-        for (int n = c; n < N; ++n) {
-            AFactorial.insert(
-                {GetAFactorialKey(n, c), (n - c + 1)*AFactorial[GetAFactorialKey(n, c - 1)]}
-            );
-        }
-    };
-
-    // 3. populate ATriplets:
+    // 2. populate ATriplets:
     {
-        int currentConstraintIdx{0};
-
         //
-        // 3.1 boundary value equality constraints:
+        // 2.1 boundary value, intermediate waypoint passing & continuity equality constraints:
         //
+        int currentConstraintIdx = Kernel::AddWaypointConstraintTriplets(Pos, Vel, Acc, Time, ATriplets, b);
 
-        // init:
-        Eigen::MatrixXd boundaryValues = Eigen::MatrixXd::Zero(2, cOrder + 1);
-        boundaryValues(0, 0) = Pos(0);
-        boundaryValues(0, 1) = Vel(0);
-        boundaryValues(0, 2) = Acc(0);
-        boundaryValues(1, 0) = Pos(K);
-        boundaryValues(1, 1) = Vel(1);
-        boundaryValues(1, 2) = Acc(1);
-
-        // populate constraints:
-        for (int c = 0; c <= cOrder; ++c) {
-            // start waypoint:
-            ATriplets.emplace_back(
-                currentConstraintIdx, c, AFactorial[GetAFactorialKey(c, c)]/ATimePower[c](0)
-            );
-            b(currentConstraintIdx) = boundaryValues(0, c);
-            
-            ++currentConstraintIdx;
-
-            // end waypoint:
-            for (int n = c; n < N; ++n) {
-                ATriplets.emplace_back(
-                    currentConstraintIdx, (K - 1)*N + n, AFactorial[GetAFactorialKey(n, c)]/ATimePower[c](K - 1)
-                );
-            }
-            b(currentConstraintIdx) = boundaryValues(1, c);
-
-            ++currentConstraintIdx;
-        }
-
         //
-        // 3.2 intermediate waypoint passing equality constraints:
+        // 2.2 safe flight corridor inequality constraints:
+        //
+        //     either at evenly spaced samples within each segment, or on the control points of its Bezier curve. the
+        //     curve is in the convex hull of its control points, so the latter keeps the whole segment in its box
         //
-        for (int k = 1; k < K; ++k) {
-            ATriplets.emplace_back(
-                currentConstraintIdx, k*N, 1.0
-            );
-            b(currentConstraintIdx) = Pos(k);
+        bUpper = b;
+        const Block &BernsteinTransform = Kernel::GetBernsteinTransform();
+        for (int k = 0; k < K && numCorridorSamples > 0 && isHullConstrained; ++k) {
+            for (int i = 0; i < N; ++i) {
+                for (int n = 0; n <= i; ++n) {
+                    ATriplets.emplace_back(
+                        currentConstraintIdx, k * N + n, BernsteinTransform(i, n)
+                    );
+                }
+                b.row(currentConstraintIdx) = Corridor.block(k, 0, 1, numDims);
+                bUpper.row(currentConstraintIdx) = Corridor.block(k, numDims, 1, numDims);
 
-            ++currentConstraintIdx;
+                ++currentConstraintIdx;
+            }
         }
+        for (int k = 0; k < K && numCorridorSamples > 0 && !isHullConstrained; ++k) {
+            for (int i = 1; i <= numSamples; ++i) {
+                const double t = static_cast<double>(i) / (numSamples + 1);
 
-        //
-        // 3.3 intermediate waypoint continuity constaints:
-        //
-        for (int c = 0; c <= cOrder; ++c) {
-            for (int k = 1; k < K; ++k) {
-                // the end of previous trajectory segment:
-                for (int n = c; n < N; ++n) {
+                double tPower{1.0};
+                for (int n = 0; n < N; ++n) {
                     ATriplets.emplace_back(
-                        currentConstraintIdx, 
-                        (k - 1) * N + n,
-                        AFactorial[GetAFactorialKey(n, c)]/ATimePower[c](k - 1)
+                        currentConstraintIdx, k * N + n, tPower
                     );
+                    tPower *= t;
                 }
+                b.row(currentConstraintIdx) = Corridor.block(k, 0, 1, numDims);
+                bUpper.row(currentConstraintIdx) = Corridor.block(k, numDims, 1, numDims);
 
-                // should equal to the start of current trajectory segment:
-                ATriplets.emplace_back(
-                    currentConstraintIdx,
-                    k * N + c,
-                    -AFactorial[GetAFactorialKey(c, c)]/ATimePower[c](k) 
-                );
-
-                // set next constraint:
                 ++currentConstraintIdx;
             }
         }
     }
 
-    // 4. populate A:
+    // 3. populate A:
     A.setFromTriplets(std::begin(ATriplets),std::end(ATriplets));
 
     //
     // solve with OSQP c++
     //
-    osqp::OsqpInstance instance;
-    instance.objective_matrix = P;
-    instance.objective_vector = Eigen::VectorXd::Zero(D);
+    //     P & A only depend on the time allocation, so the solver is set up and factorizes its KKT system once,
+    //     then each dimension only updates the bounds
+    //
+    // 1. warm start, per dimension:
+    Eigen::MatrixXd primalWarmStart = Eigen::MatrixXd::Zero(D, numDims);
+    Eigen::MatrixXd dualWarmStart = Eigen::MatrixXd::Zero(C, numDims);
+
+    // 2. reuse the solver of the session:
+    osqp::OsqpSolver localSolver;
+    bool isUpdated{false};
+    bool isWarmStarted{false};
+
+    if (session != nullptr) {
+        if (!session->solver) {
+            session->solver = std::make_unique<osqp::OsqpSolver>();
+        }
 
-    instance.constraint_matrix = A;
-    instance.lower_bounds = instance.upper_bounds = b;
+        const bool isSameProblem = (
+            session->tOrder == tOrder && session->cOrder == COrder && session->numDims == numDims
+        );
 
-    osqp::OsqpSolver solver;
-    osqp::OsqpSettings settings;
+        if (isSameProblem && session->numSegments == K && session->numConstraints == C) {
+            // same sparsity, update P & A in place and start from the previous iterates:
+            isUpdated = session->solver->UpdateObjectiveAndConstraintMatrices(P, A).ok();
+            if (isUpdated) {
+                primalWarmStart = session->primal;
+                dualWarmStart = session->dual;
+                isWarmStarted = true;
+            }
+        } else if (isSameProblem && session->numSegments + 1 == K) {
+            // a waypoint inserted into segment j - 1 splits it into segments j - 1 & j, the others are kept:
+            const int j = FindInsertedWaypoint(session->Pos, Pos);
+            if (j > 0) {
+                const double tau = Time(j - 1) / (Time(j - 1) + Time(j));
+
+                primalWarmStart.topRows((j - 1) * N) = session->primal.topRows((j - 1) * N);
+                primalWarmStart.bottomRows((K - j - 1) * N) = session->primal.bottomRows((K - j - 1) * N);
+
+                for (int dim = 0; dim < numDims; ++dim) {
+                    State head, tail;
+                    Kernel::Split(session->primal.col(dim).template segment<N>((j - 1) * N), tau, head, tail);
+
+                    primalWarmStart.col(dim).template segment<N>((j - 1) * N) = head;
+                    primalWarmStart.col(dim).template segment<N>(j * N) = tail;
+                }
+
+                // the constraints are new, so are their multipliers:
+                isWarmStarted = true;
+            }
+        }
+    }
+
+    osqp::OsqpSolver &solver = (session != nullptr ? *session->solver : localSolver);
+
+    // 3. otherwise set up the solver from scratch:
+    if (!isUpdated) {
+        osqp::OsqpInstance instance;
+        instance.objective_matrix = P;
+        instance.objective_vector = Eigen::VectorXd::Zero(D);
+
+        instance.constraint_matrix = A;
+        instance.lower_bounds = b.col(0);
+        instance.upper_bounds = bUpper.col(0);
+
+        osqp::OsqpSettings settings;
+
+        // init solver:
+        if (!solver.Init(instance, settings).ok()) {
+            // defaults to Eigen::MatrixXd::Zero():
+            ROS_WARN("[Minimum Snap, Numeric]: Failed to init OSQP solver.");
+            if (session != nullptr) {
+                session->Reset();
+            }
+            return (numCorridorSamples > 0 ? Eigen::MatrixXd() : result);
+        }
+    }
+
+    double optimalObject{0.0};
+    int numIterations{0};
+    int numSolvedDims{0};
+    for (int dim = 0; dim < numDims; ++dim) {
+        // set bounds & the starting iterates of the dimension:
+        if (
+            !solver.SetBounds(b.col(dim), bUpper.col(dim)).ok() ||
+            !solver.SetWarmStart(primalWarmStart.col(dim), dualWarmStart.col(dim)).ok()
+        ) {
+            // defaults to Eigen::MatrixXd::Zero():
+            ROS_WARN("[Minimum Snap, Numeric]: Failed to update OSQP solver for dimension %d.", dim);
+            primalWarmStart.col(dim).setZero();
+            dualWarmStart.col(dim).setZero();
+            continue;
+        }
 
-    // init solver:
-    if (solver.Init(instance, settings).ok()) {
         // solve.
         const auto exitCode = solver.Solve();
+        numIterations += solver.iterations();
 
         if (exitCode == osqp::OsqpExitCode::kOptimal) {
             // get optimal solution
-            const auto optimalObject = solver.objective_value();
+            optimalObject += solver.objective_value();
             const auto optimalCoeffs = solver.primal_solution();
+            ++numSolvedDims;
+
+            // keep the iterates for the next call:
+            primalWarmStart.col(dim) = optimalCoeffs;
+            dualWarmStart.col(dim) = solver.dual_solution();
 
             //
             // format output:
             //
-            Eigen::VectorXd timeScalings = Eigen::VectorXd::Ones(N);
+            Eigen::Matrix<double, N, 1> timeScalings = Eigen::Matrix<double, N, 1>::Ones();
             for (int k = 0; k < K; ++k) {
                 for (int n = 1; n < N; ++n) {
                     timeScalings(n) = timeScalings(n - 1) / Time(k);
                 }
-                result.row(k) = optimalCoeffs.segment(k * N, N).cwiseProduct(timeScalings);;
+                result.block(k, dim * N, 1, N) = optimalCoeffs.segment(k * N, N).cwiseProduct(timeScalings).transpose();
             }
-
-            ROS_WARN("[Minimum Snap, Numeric]: Optimal objective is %.2f.", optimalObject);
         } else {
             // defaults to Eigen::MatrixXd::Zero():
-            ROS_WARN("[Minimum Snap, Numeric]: Failed to find the optimal solution.");
+            ROS_WARN("[Minimum Snap, Numeric]: Failed to find the optimal solution for dimension %d.", dim);
+            primalWarmStart.col(dim).setZero();
+            dualWarmStart.col(dim).setZero();
         }
-    } else {
-        // defaults to Eigen::MatrixXd::Zero():
-        ROS_WARN("[Minimum Snap, Numeric]: Failed to init OSQP solver.");
     }
 
+    // 4. keep the problem for the next call:
+    if (session != nullptr) {
+        session->tOrder = tOrder;
+        session->cOrder = COrder;
+        session->numSegments = K;
+        session->numConstraints = C;
+        session->numDims = numDims;
+
+        session->Pos = Pos;
+        session->primal = std::move(primalWarmStart);
+        session->dual = std::move(dualWarmStart);
+
+        session->numIterations = numIterations;
+        session->isWarmStarted = isWarmStarted;
+    }
+
+    if (numCorridorSamples > 0 && numSolvedDims < numDims) {
+        // the corridor may be infeasible, which is told apart from a trajectory through the origin by empty output:
+        ROS_WARN("[Minimum Snap, Numeric]: No trajectory found in the safe flight corridor.");
+        return Eigen::MatrixXd();
+    }
+
+    ROS_WARN("[Minimum Snap, Numeric]: Optimal objective is %.2f.", optimalObject);
+
     // done:
     return result;
 }
@@ -779,263 +1087,209 @@ Eigen::MatrixXd TrajectoryOptimizer::DoTrajectoryGenerationNumerically(
 Eigen::MatrixXd TrajectoryOptimizer::DoTrajectoryGenerationAnalytically(
     const int tOrder,       
     const int cOrder,    
-    const Eigen::VectorXd &Pos,
-    const Eigen::VectorXd &Vel,
-    const Eigen::VectorXd &Acc,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time
+) {
+    switch (cOrder) {
+        case 2:
+            return DoTrajectoryGenerationAnalytically<2>(tOrder, Pos, Vel, Acc, Time);
+        case 3:
+            return DoTrajectoryGenerationAnalytically<3>(tOrder, Pos, Vel, Acc, Time);
+        default:
+            // defaults to Eigen::MatrixXd::Zero():
+            ROS_WARN("[Minimum Snap, Analytic]: cOrder %d is not supported, only 2 & 3 are.", cOrder);
+            return Eigen::MatrixXd::Zero(Time.size(), Pos.cols() * GetNumCoeffs(cOrder));
+    }
+}
+
+template <int COrder>
+Eigen::MatrixXd TrajectoryOptimizer::DoTrajectoryGenerationAnalytically(
+    const int tOrder,       
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
     const Eigen::VectorXd &Time
 ) {
     // num. of polynomial coeffs:
-    const auto N = GetNumCoeffs(cOrder);
+    constexpr int N = MinimumSnapTrajectory<COrder>::N;
     // num. of trajectory segments:
-    const auto K = Time.size();
-    // dim of flattened output, direct:
-    const auto D = K * N;
-    // dim of flattened output, latent:
-    const auto L = (K + 1) * (cOrder + 1);
-    const auto LFixed = (
-        // 1. boundary value equality constraints:
-        N + 
-        // 2. intermediate waypoint passing equality constraints:
-        (K - 1)
-    );
-    const auto LVariable = L - LFixed;
+    const int K = Time.size();
+    // num. of dimensions:
+    const int numDims = Pos.cols();
+
+    if (tOrder < 0 || tOrder >= N) {
+        // defaults to Eigen::MatrixXd::Zero():
+        ROS_WARN("[Minimum Snap, Analytic]: tOrder %d is out of range for %d coeffs.", tOrder, N);
+        return Eigen::MatrixXd::Zero(K, numDims * N);
+    }
 
     //
-    // init output:
+    // solve the start & end state of each segment by the banded system of MinimumSnapTrajectory:
     //
-    //     the trajectory segment k is defined by result(k, 0) + t*(result(k, 1) + ...)
-    // 
-    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(K, N);
-
-    // 
-    // define objective matrix P:
+    //     the trajectory segment k of dimension dim is defined by result(k, dim*N) + t*(result(k, dim*N + 1) + ...)
     //
-    // 1. init:
-    Eigen::SparseMatrix<double> P(D, D);
-    std::vector<Eigen::Triplet<double>> PTriplets;
-    
-    // 2. cache results for objective matrix construction:
-    // 2.a time power
-    Eigen::VectorXd PTimePower = Eigen::VectorXd::Ones(K);
-    for (int c = 1; c < tOrder; ++c) {
-        PTimePower = PTimePower.cwiseProduct(Time);
-    }
-    // 2.b factorial
-    std::map<int, double> PFactorial;
-    for (int n = tOrder; n < N; ++n) {
-        PFactorial.insert(
-            {n, GetFactorial(n, tOrder)}
-        );
+    MinimumSnapTrajectory<COrder> trajectory(tOrder);
+    if (!trajectory.Generate(Pos, Vel, Acc, Time)) {
+        // defaults to Eigen::MatrixXd::Zero():
+        return Eigen::MatrixXd::Zero(K, numDims * N);
     }
 
-    // 3. populate PTriplets:
-    for (int k = 0; k < K; ++k) {
-        const auto currentSegmentIdxOffset = k * N;
-
-        for (int m = tOrder; m < N; ++m) {
-            for (int n = tOrder; n < N; ++n) {
-                PTriplets.emplace_back(
-                    currentSegmentIdxOffset + m,
-                    currentSegmentIdxOffset + n,
-                    Time(k)*PFactorial[m]*PFactorial[n]/(
-                        (m + n - (tOrder << 1) + 1) *
-                        PTimePower(k) * PTimePower(k)
-                    )
-                );
-            }
-        }
+    ROS_WARN("[Minimum Snap, Analytic]: Optimal objective is %.2f.", trajectory.GetObjective());
+
+    // done:
+    return trajectory.GetCoeffs();
+}
+
+template <int COrder>
+Eigen::VectorXd TrajectoryOptimizer::DoTimesOptimization(
+    const int tOrder,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    const double timeWeight,
+    const int maxIterations
+) {
+    // num. of polynomial coeffs:
+    constexpr int N = MinimumSnapTrajectory<COrder>::N;
+    // num. of trajectory segments:
+    const int K = Time.size();
+
+    if (tOrder < 0 || tOrder >= N) {
+        // defaults to the initial time allocations:
+        ROS_WARN("[Time Allocation]: tOrder %d is out of range for %d coeffs.", tOrder, N);
+        return Time;
     }
 
-    // 4. populate P:
-    P.setFromTriplets(std::begin(PTriplets),std::end(PTriplets));
+    // tic:
+    const auto tStart = std::chrono::high_resolution_clock::now();
 
     //
-    // define derivative matrix M:
+    // objective & its gradient in log time x_k = log(T_k), which keeps the times positive:
     //
-    // 1. init:
-    Eigen::SparseMatrix<double> M(D, D);
-    std::vector<Eigen::Triplet<double>> MTriplets;
-
-    // 2. cache results for constraint matrix construction:
-    std::map<int, Eigen::VectorXd> MTimePower;
-    std::map<int, double> MFactorial;
-
-    // 2.a init:
-    MTimePower.insert(
-        {0, Eigen::VectorXd::Ones(K)}
-    );
-    
-    auto GetMFactorialKey = [&](const int n, const int d) {
-        return d * N + n;
-    };
-    for (int n = 0; n < N; ++n) {
-        MFactorial.insert(
-            {GetMFactorialKey(n, 0), 1.0}
-        );
+    //     f = J(T) + timeWeight * sum(T), with J the optimal objective for the time allocation T. the waypoints stay
+    //     where they are, so every evaluation only refactorizes the banded system of the trajectory for the new times
+    //
+    MinimumSnapTrajectory<COrder> trajectory(tOrder);
+    if (!trajectory.Generate(Pos, Vel, Acc, Time)) {
+        return Time;
     }
 
-    for (int c = 1; c <= cOrder; ++c) {
-        // 2.b time power pre-computing:
-        MTimePower.insert(
-            {c, MTimePower[c - 1].cwiseProduct(Time)}
-        );
+    Eigen::MatrixXd gradPos;
+    Eigen::VectorXd gradTime;
 
-        // 2.c factorial pre-computing:
-        for (int n = c; n < N; ++n) {
-            MFactorial.insert(
-                {GetMFactorialKey(n, c), (n - c + 1)*MFactorial[GetMFactorialKey(n, c - 1)]}
-            );
+    auto Evaluate = [&](const Eigen::VectorXd &x, double &f, Eigen::VectorXd &gradient) -> bool {
+        const Eigen::VectorXd T = x.array().exp();
+        if (!trajectory.SetTimes(T)) {
+            return false;
         }
-    };
-
-    // 3. populate MTriplets:
-    {
-        int currentStateIndex{0};
-
-        for (int k = 0; k < K; ++k) {
-            for (int c = 0; c <= cOrder; ++c) {
-                // the start state defined by current traj. seg.:
-                MTriplets.emplace_back(
-                    currentStateIndex++,
-                    k * N + c,
-                    MFactorial[GetMFactorialKey(c, c)]/MTimePower[c](k) 
-                );
-            }
 
-            for (int c = 0; c <= cOrder; ++c) {
-                // the end state defined by current traj. seg.:
-                for (int n = c; n < N; ++n) {
-                    MTriplets.emplace_back(
-                        currentStateIndex, 
-                        k * N + n,
-                        MFactorial[GetMFactorialKey(n, c)]/MTimePower[c](k)
-                    );
-                }
-                ++currentStateIndex;
-            }
-        }
-    }
+        trajectory.GetObjectiveGradient(gradPos, gradTime);
 
-    // 4. populate M:
-    M.setFromTriplets(std::begin(MTriplets),std::end(MTriplets));
+        f = trajectory.GetObjective() + timeWeight * T.sum();
+        // dT_k/dx_k = T_k:
+        gradient = (gradTime.array() + timeWeight) * T.array();
 
-    // 5. get inverse M:
-    // 5.1 decompose:
-    Eigen::SparseQR<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>> solver;
-    solver.compute(M);
-    if(solver.info() != Eigen::Success) {
-        // decomposition failed
-        ROS_WARN("[Minimum Snap, Analytic]: Failed to decompose derivative matrix M.");
-    }
-    // 5.2 inverse:
-    Eigen::SparseMatrix<double> I(D,D);
-    I.setIdentity();
-    auto MInv = solver.solve(I);
-    if(solver.info() != Eigen::Success) {
-        // matrix inverse failed
-        ROS_WARN("[Minimum Snap, Analytic]: Failed to compute the inverse derivative matrix M.");
-    }
+        return true;
+    };
 
     //
-    // define selection matrix C:
+    // L-BFGS with backtracking line search:
     //
     // 1. init:
-    Eigen::SparseMatrix<double> C(D, L);
-    std::vector<Eigen::Triplet<double>> CTriplets;
+    Eigen::VectorXd x = Time.array().log();
+    Eigen::VectorXd gradient(K);
+    double f{0.0};
+    if (!Evaluate(x, f, gradient)) {
+        return Time;
+    }
+    const double initialObject = f;
+
+    Eigen::MatrixXd sHistory(K, TimesMemory), yHistory(K, TimesMemory);
+    std::array<double, TimesMemory> rhoHistory, alpha;
+    int numPairs{0}, newest{-1};
+
+    Eigen::VectorXd xNext(K), gradientNext(K), direction(K);
+    int numSteps{0};
+    while (numSteps < maxIterations) {
+        // 2. search direction by the two-loop recursion:
+        direction = -gradient;
+        for (int i = 0; i < numPairs; ++i) {
+            const int m = (newest - i + TimesMemory) % TimesMemory;
+            alpha[m] = rhoHistory[m] * sHistory.col(m).dot(direction);
+            direction -= alpha[m] * yHistory.col(m);
+        }
+        if (numPairs > 0) {
+            direction *= sHistory.col(newest).dot(yHistory.col(newest)) / yHistory.col(newest).squaredNorm();
+        }
+        for (int i = numPairs - 1; i >= 0; --i) {
+            const int m = (newest - i + TimesMemory) % TimesMemory;
+            const double beta = rhoHistory[m] * yHistory.col(m).dot(direction);
+            direction += (alpha[m] - beta) * sHistory.col(m);
+        }
 
-    // 2. populate CTriplets:
-    {
-        // 
-        // latent variable definition L is defined as LFixed plus LVariable
-        //
-        int currentStateIndex{0};
-
-        // 2.1 map fixed latent variables, boundary value constraints:
-        for (int c = 0; c <= cOrder; ++c) {
-            CTriplets.emplace_back(
-                c,
-                currentStateIndex,
-                1.0
-            );
-            ++currentStateIndex;
-
-            CTriplets.emplace_back(
-                (K - 1) * N + (cOrder + 1 + c),
-                currentStateIndex,
-                1.0
-            );
-            ++currentStateIndex;
+        // fall back to steepest descent, from scratch, if the curvature pairs went stale:
+        if (gradient.dot(direction) >= 0.0) {
+            direction = -gradient;
+            numPairs = 0;
         }
 
-        // map the rest:
-        for (int c = 0; c <= cOrder; ++c) {
-            // 2.2 intermediate waypoint passing constraints will be mapped when c = 0:
-            // 2.3 actual decision latent variables will be mapped when c > 0:
-            for (int k = 1; k < K; ++k) {
-                CTriplets.emplace_back(
-                    (k - 1) * N + (cOrder + 1 + c),
-                    currentStateIndex,
-                    1.0
-                );
+        // bounded step:
+        const double maxStep = direction.cwiseAbs().maxCoeff();
+        if (maxStep > TimesMaxLogStep) {
+            direction *= TimesMaxLogStep / maxStep;
+        }
 
-                CTriplets.emplace_back(
-                    k * N + c,
-                    currentStateIndex,
-                    1.0
-                );
-                
-                ++currentStateIndex;
+        // 3. backtracking line search for sufficient decrease:
+        const double slope = gradient.dot(direction);
+        double fNext{f}, step{1.0};
+        bool isDecreased{false};
+        for (int i = 0; i < TimesLineSearchSteps; ++i, step *= 0.5) {
+            xNext = x + step * direction;
+            if (Evaluate(xNext, fNext, gradientNext) && fNext <= f + 1e-4 * step * slope) {
+                isDecreased = true;
+                break;
             }
         }
-    }
-
-    // 4. populate C:
-    C.setFromTriplets(std::begin(CTriplets),std::end(CTriplets));
-
-    //
-    // build problem:
-    //
-    // 1. define fixed variables:
-    Eigen::VectorXd outputLatent = Eigen::VectorXd::Zero(L);
-    // 1.a boundary value equality constraints:
-    outputLatent(0) = Pos(0);
-    outputLatent(1) = Pos(K);
-    outputLatent(2) = Vel(0);
-    outputLatent(3) = Vel(1);
-    outputLatent(4) = Acc(0);
-    outputLatent(5) = Acc(1);
-    // 1.b intermediate waypoint passing equality constraints:
-    for (int k = 1; k < K; ++k) {
-        outputLatent(N + k - 1) = Pos(k);
-    }
 
-    // 2. define A & b for least squared:
-    Eigen::MatrixXd PDense(C.transpose() * MInv.transpose() * P * MInv * C);
-
-    const Eigen::MatrixXd& A = PDense.block(LFixed, LFixed, LVariable, LVariable);
-    const Eigen::VectorXd b = -PDense.block(LFixed,      0, LVariable,    LFixed)*outputLatent.segment(0, LFixed);
-
-    // 3. get latent output:
-    outputLatent.segment(LFixed, LVariable) = A.colPivHouseholderQr().solve(b);
+        if (!isDecreased) {
+            break;
+        }
 
-    // 4. get direct output:
-    const Eigen::VectorXd outputDirect = MInv * C * outputLatent;
+        // 4. update curvature pairs, skipping the ones which are not positive:
+        const double decrease = f - fNext;
+        const Eigen::VectorXd s = xNext - x;
+        const Eigen::VectorXd y = gradientNext - gradient;
+        const double sy = s.dot(y);
+        if (sy > std::numeric_limits<double>::epsilon() * y.squaredNorm()) {
+            newest = (newest + 1) % TimesMemory;
+            sHistory.col(newest) = s;
+            yHistory.col(newest) = y;
+            rhoHistory[newest] = 1.0 / sy;
+            numPairs = std::min(numPairs + 1, TimesMemory);
+        }
 
-    // 5. get optimal objective:
-    const auto optimalObject = (0.50 * outputDirect.transpose() * P * outputDirect);
-    ROS_WARN("[Minimum Snap, Analytic]: Optimal objective is %.2f.", optimalObject(0, 0));
+        x.swap(xNext);
+        gradient.swap(gradientNext);
+        f = fNext;
+        ++numSteps;
 
-    //
-    // format output:
-    //
-    Eigen::VectorXd timeScalings = Eigen::VectorXd::Ones(N);
-    for (int k = 0; k < K; ++k) {
-        for (int n = 1; n < N; ++n) {
-            timeScalings(n) = timeScalings(n - 1) / Time(k);
+        // 5. converged:
+        if (decrease <= TimesRelativeTolerance * f) {
+            break;
         }
-        result.row(k) = outputDirect.segment(k * N, N).cwiseProduct(timeScalings);;
     }
 
-    // done:
-    return result;
+    // toc:
+    const auto tEnd = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> durationMs = tEnd - tStart;
+
+    ROS_WARN(
+        "[Time Allocation]: objective from %.2f to %.2f in %d steps, time elapsed %.2f ms", 
+        initialObject, f, numSteps, durationMs.count()
+    );
+
+    return x.array().exp();
 }
@@ -0,0 +1,37 @@
+# opt-in AVX2 for the vectorised kernels of the grid_path_searcher packages of 03 & 04.
+#
+# the kernels are guarded by __AVX2__ and fall back to scalar loops, so the default build runs anywhere. when
+# ENABLE_AVX2 is on, -mavx2 is only added to the given targets, and only for x86 toolchains which accept it.
+# the resulting binaries need an AVX2 capable CPU at runtime.
+#
+# usage:
+#
+#     include(${CMAKE_CURRENT_SOURCE_DIR}/../../../../cmake/EnableAVX2.cmake)
+#     target_enable_avx2(demo_node)
+
+if(COMMAND target_enable_avx2)
+    return()
+endif()
+
+include(CheckCXXCompilerFlag)
+
+option(ENABLE_AVX2 "build the vectorised kernels with AVX2, the binaries then need an AVX2 capable CPU" OFF)
+
+function(target_enable_avx2 target)
+    if(NOT ENABLE_AVX2)
+        return()
+    endif()
+
+    if(NOT CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|amd64|i[3-6]86|x86)$")
+        message(WARNING "ENABLE_AVX2: ${CMAKE_SYSTEM_PROCESSOR} is not x86, ${target} keeps the scalar kernels")
+        return()
+    endif()
+
+    check_cxx_compiler_flag(-mavx2 COMPILER_SUPPORTS_AVX2)
+    if(NOT COMPILER_SUPPORTS_AVX2)
+        message(WARNING "ENABLE_AVX2: the compiler does not accept -mavx2, ${target} keeps the scalar kernels")
+        return()
+    endif()
+
+    target_compile_options(${target} PRIVATE -mavx2)
+endfunction()
@@ -0,0 +1,184 @@
+#ifndef ASSIGNMENTS_OBVP_CLOSED_FORM_HPP_
+#define ASSIGNMENTS_OBVP_CLOSED_FORM_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief closed-form time-optimal OBVP of the double integrator with fixed final state, J = T + integral of |a|^2
+ *
+ * @note with a = |v0|^2 + v0.v1 + |v1|^2, b = dp.(v0 + v1), c = |dp|^2 the cost of the optimal cubic is
+ *       J(T) = T + 4a/T - 12b/T^2 + 12c/T^3, and dJ/dT * T^4 = T^4 - 4a*T^2 + 24b*T - 36c = 0 is a depressed quartic,
+ *       solved with Ferrari's method & polished by Newton iterations. nothing allocates or logs, so it is safe in inner
+ *       loops. shared by the OBVP planners of 04 & the capstone, C++11
+ */
+namespace obvp_closed_form {
+// Newton iterations polishing the roots of the resolvent cubic & of the quartic:
+const int NewtonIterations = 2;
+
+/**
+  * @brief find real roots of x^2 + b*x + c
+  *
+  * @return num. of real roots
+  */
+inline int SolveQuadratic(const double b, const double c, double *roots) {
+    const double discriminant = b*b - 4.0*c;
+    if (discriminant < 0.0) {
+        return 0;
+    }
+
+    // avoid cancellation between -b and the square root:
+    const double t = -0.5 * (b + std::copysign(std::sqrt(discriminant), b));
+    if (t == 0.0) {
+        roots[0] = 0.0;
+        return 1;
+    }
+
+    roots[0] = t;
+    roots[1] = c / t;
+
+    return 2;
+}
+
+/**
+  * @brief find the largest real root of m^3 + a*m^2 + b*m + c
+  */
+inline double SolveCubicLargest(const double a, const double b, const double c) {
+    // substitute m = y - a/3 to get y^3 + P*y + Q = 0:
+    const double aThird = a / 3.0;
+    const double P = b - a * aThird;
+    const double Q = (2.0 * aThird * aThird - b) * a / 3.0 + c;
+
+    const double discriminant = 0.25*Q*Q + P*P*P/27.0;
+
+    double y = 0.0;
+    if (discriminant > 0.0) {
+        const double sqrtDiscriminant = std::sqrt(discriminant);
+        y = std::cbrt(-0.5*Q + sqrtDiscriminant) + std::cbrt(-0.5*Q - sqrtDiscriminant);
+    } else if (P < 0.0) {
+        // three real roots, take the largest one from the trigonometric form:
+        const double rho = std::sqrt(-P / 3.0);
+        const double cosTheta = std::max(-1.0, std::min(1.0, -0.5 * Q / (rho * rho * rho)));
+        y = 2.0 * rho * std::cos(std::acos(cosTheta) / 3.0);
+    }
+
+    double m = y - aThird;
+    for (int i = 0; i < NewtonIterations; ++i) {
+        const double f = ((m + a)*m + b)*m + c;
+        const double df = (3.0*m + 2.0*a)*m + b;
+        if (df == 0.0) {
+            break;
+        }
+        m -= f / df;
+    }
+
+    return m;
+}
+
+/**
+  * @brief find real roots of depressed quartic x^4 + p*x^2 + q*x + r
+  *
+  * @param[in] p quadratic coeff
+  * @param[in] q linear coeff
+  * @param[in] r constant coeff
+  * @param[out] roots real roots, polished by Newton iterations
+  *
+  * @return num. of real roots
+  */
+inline int SolveDepressedQuartic(const double p, const double q, const double r, double roots[4]) {
+    int numRoots = 0;
+
+    //
+    // Ferrari: with m > 0 solving the resolvent cubic m^3 + p*m^2 + (p^2/4 - r)*m - q^2/8 = 0 and s = sqrt(2m),
+    // x^4 + p*x^2 + q*x + r = (x^2 - s*x + p/2 + m + q/(2s)) * (x^2 + s*x + p/2 + m - q/(2s))
+    //
+    const double m = SolveCubicLargest(p, 0.25*p*p - r, -0.125*q*q);
+
+    if (!(m > 1e-12 * (1.0 + std::abs(p)))) {
+        // q vanishes, biquadratic in x^2:
+        double squares[2];
+        const int numSquares = SolveQuadratic(p, r, squares);
+        for (int i = 0; i < numSquares; ++i) {
+            if (squares[i] < 0.0) {
+                continue;
+            }
+
+            const double x = std::sqrt(squares[i]);
+            roots[numRoots++] = x;
+            if (x > 0.0) {
+                roots[numRoots++] = -x;
+            }
+        }
+    } else {
+        const double s = std::sqrt(2.0 * m);
+        const double constant = 0.5*p + m;
+        const double offset = 0.5 * q / s;
+
+        numRoots += SolveQuadratic(-s, constant + offset, roots);
+        numRoots += SolveQuadratic(+s, constant - offset, roots + numRoots);
+    }
+
+    // Newton polishing:
+    for (int i = 0; i < numRoots; ++i) {
+        double &x = roots[i];
+        for (int j = 0; j < NewtonIterations; ++j) {
+            const double xSquared = x * x;
+            const double f = ((xSquared + p)*x + q)*x + r;
+            const double df = (4.0*xSquared + 2.0*p)*x + q;
+            if (df == 0.0) {
+                break;
+            }
+            x -= f / df;
+        }
+    }
+
+    return numRoots;
+}
+
+/**
+  * @brief cost J(T) of the optimal cubic of duration T
+  */
+inline double EvaluateCost(const double a, const double b, const double c, const double T) {
+    return T + (4.0*a + (-12.0*b + 12.0*c/T)/T)/T;
+}
+
+/**
+  * @brief solve the time-optimal OBVP in closed form
+  *
+  * @param[in] a |v0|^2 + v0.v1 + |v1|^2
+  * @param[in] b dp.(v0 + v1)
+  * @param[in] c |dp|^2
+  * @param[in] minTime smallest traversal time accepted as a solution
+  * @param[out] optimalTime optimal traversal time, 0.0 if there is none above minTime
+  *
+  * @return optimal cost, infinity if there is no traversal time above minTime
+  */
+inline double Solve(const double a, const double b, const double c, const double minTime, double &optimalTime) {
+    double optimalCost = std::numeric_limits<double>::infinity();
+    optimalTime = 0.0;
+
+    // dJ/dT * T^4 = T^4 - 4a*T^2 + 24b*T - 36c:
+    double roots[4];
+    const int numRoots = SolveDepressedQuartic(-4.0*a, 24.0*b, -36.0*c, roots);
+
+    for (int i = 0; i < numRoots; ++i) {
+        const double T = roots[i];
+
+        // positive real root only:
+        if (T <= minTime) {
+            continue;
+        }
+
+        const double cost = EvaluateCost(a, b, c, T);
+        if (cost < optimalCost) {
+            optimalCost = cost;
+            optimalTime = T;
+        }
+    }
+
+    return optimalCost;
+}
+}
+
+#endif // ASSIGNMENTS_OBVP_CLOSED_FORM_HPP_
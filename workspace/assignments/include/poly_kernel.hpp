@@ -0,0 +1,316 @@
+#ifndef ASSIGNMENTS_POLY_KERNEL_HPP_
+#define ASSIGNMENTS_POLY_KERNEL_HPP_
+
+#include <Eigen/Eigen>
+
+#include <array>
+#include <vector>
+
+/**
+ * @brief get the table of partial factorials n!/(n - d)!, the factor of t^(n - d) in the [d]th derivative of t^n
+ */
+template <int N>
+constexpr std::array<std::array<double, N>, N> GetFactorialTable() {
+  std::array<std::array<double, N>, N> factorials{};
+
+  for (int d = 0; d < N; ++d) {
+    for (int n = d; n < N; ++n) {
+      factorials[d][n] = 1.0;
+      for (int i = 0; i < d; ++i) {
+        factorials[d][n] *= (n - i);
+      }
+    }
+  }
+
+  return factorials;
+}
+
+/**
+ * @brief compile-time sized building blocks of the piecewise polynomials which are [COrder]th continuous at intermediate waypoints
+ *
+ * @note shared by the minimum snap generators of 05 & the capstone, the coeffs of each segment are in unit time
+ */
+template <int COrder>
+struct PolyKernel {
+  // num. of derivatives fixed or solved at each waypoint:
+  static constexpr int S = COrder + 1;
+  // num. of polynomial coeffs:
+  static constexpr int N = S << 1;
+
+  using Block = Eigen::Matrix<double, N, N>;
+  using State = Eigen::Matrix<double, N, 1>;
+
+  // Factorials[d][n] = n!/(n - d)!:
+  static constexpr std::array<std::array<double, N>, N> Factorials = GetFactorialTable<N>();
+
+  /**
+   * @brief get the inverse of M0, which maps the coeffs of a segment with unit time to its start & end state
+   */
+  static const Block &GetM0Inverse() {
+    static const Block M0Inverse = [] {
+      Block M0 = Block::Zero();
+      for (int c = 0; c < S; ++c) {
+        M0(c, c) = Factorials[c][c];
+        for (int n = c; n < N; ++n) {
+          M0(S + c, n) = Factorials[c][n];
+        }
+      }
+      return Block(M0.inverse());
+    }();
+
+    return M0Inverse;
+  }
+
+  /**
+   * @brief get the objective matrix Q0 of a segment with unit time
+   */
+  static Block GetObjective(const int tOrder) {
+    Block Q0 = Block::Zero();
+    for (int m = tOrder; m < N; ++m) {
+      for (int n = tOrder; n < N; ++n) {
+        Q0(m, n) = Factorials[tOrder][m]*Factorials[tOrder][n]/(m + n - (tOrder << 1) + 1);
+      }
+    }
+
+    return Q0;
+  }
+
+  /**
+   * @brief get the objective weight of a segment, its objective matrix is the weight times Q0
+   *
+   * @note with t = T*s the [tOrder]th derivative scales by T^-tOrder and dt by T, so the weight is T^(1 - 2*tOrder)
+   */
+  static double GetObjectiveWeight(const int tOrder, const double T) {
+    double timePower{1.0};
+    for (int c = 0; c < tOrder; ++c) {
+      timePower *= T;
+    }
+
+    return T / (timePower * timePower);
+  }
+
+  /**
+   * @brief get the exponents of T in the objective weight times the time powers of the start & end state,
+   *        T^(1 - 2*tOrder) * T^(c_i + c_j) as GetObjectiveWeight & GetTimeScalings define them
+   */
+  static Block GetObjectiveExponents(const int tOrder) {
+    const int weightExponent = 1 - (tOrder << 1);
+
+    Block exponents;
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        exponents(i, j) = weightExponent + (i % S) + (j % S);
+      }
+    }
+
+    return exponents;
+  }
+
+  /**
+   * @brief get the time powers T^c of the start & end state
+   */
+  static State GetTimeScalings(const double T) {
+    State timeScalings;
+    timeScalings(0) = timeScalings(S) = 1.0;
+    for (int c = 1; c < S; ++c) {
+      timeScalings(c) = timeScalings(S + c) = T * timeScalings(c - 1);
+    }
+
+    return timeScalings;
+  }
+
+  /**
+   * @brief get the objective H0 = M0^-T * Q0 * M0^-1 of a segment with unit time in its start & end state
+   */
+  static Block GetStateObjective(const int tOrder) {
+    const Block &M0Inv = GetM0Inverse();
+    return M0Inv.transpose() * GetObjective(tOrder) * M0Inv;
+  }
+
+  /**
+   * @brief get the objective of a segment in its start & end state, w * diag(T^c) * H0 * diag(T^c)
+   */
+  static Block GetStateObjective(const Block &H0, const int tOrder, const double T) {
+    const State timeScalings = GetTimeScalings(T);
+    return GetObjectiveWeight(tOrder, T) * H0.cwiseProduct(timeScalings * timeScalings.transpose());
+  }
+
+  /**
+   * @brief append the objective of the segments with unit time, each scaled by its weight, to the triplets of P
+   *
+   * @param[in] tOrder the L2-norm of [tOrder]th derivative is the objective
+   * @param[in] Time allocated time for each trajectory segment, K-by-1
+   * @param[out] triplets triplets of the K*N-by-K*N objective matrix
+   */
+  static void AddObjectiveTriplets(
+    const int tOrder,
+    const Eigen::VectorXd &Time,
+    std::vector<Eigen::Triplet<double>> &triplets
+  ) {
+    const Block Q0 = GetObjective(tOrder);
+
+    for (int k = 0; k < Time.size(); ++k) {
+      const int currentSegmentIdxOffset = k * N;
+      const double weight = GetObjectiveWeight(tOrder, Time(k));
+
+      for (int m = tOrder; m < N; ++m) {
+        for (int n = tOrder; n < N; ++n) {
+          triplets.emplace_back(
+            currentSegmentIdxOffset + m,
+            currentSegmentIdxOffset + n,
+            weight * Q0(m, n)
+          );
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief append the waypoint equality constraints of the segments with unit time to the triplets of A
+   *
+   * @param[in] Pos waypoints, (K + 1)-by-D
+   * @param[in] Vel boundary(start & goal) velocity specifications, 2-by-D
+   * @param[in] Acc boundary(start & goal) acceleration specifications, 2-by-D
+   * @param[in] Time allocated time for each trajectory segment, K-by-1
+   * @param[out] triplets triplets of the constraint matrix, the constraints take its first rows
+   * @param[out] b bounds of the constraints, one column per dimension, at least as many rows as constraints
+   *
+   * @return num. of constraints, N boundary values, K - 1 waypoint passings & (K - 1) * S continuities
+   */
+  static int AddWaypointConstraintTriplets(
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time,
+    std::vector<Eigen::Triplet<double>> &triplets,
+    Eigen::MatrixXd &b
+  ) {
+    const int K = Time.size();
+
+    // time powers of the start & end state of each segment:
+    auto GetTimePowers = [&](const int k) -> Eigen::Matrix<double, S, 1> {
+      return GetTimeScalings(Time(k)).template head<S>();
+    };
+
+    int currentConstraintIdx{0};
+
+    //
+    // 1. boundary value equality constraints:
+    //
+
+    // init, start & goal of the [c]th derivative in rows 2c & 2c + 1:
+    b.row(0) = Pos.row(0);
+    b.row(1) = Pos.row(K);
+    b.row(2) = Vel.row(0);
+    b.row(3) = Vel.row(1);
+    b.row(4) = Acc.row(0);
+    b.row(5) = Acc.row(1);
+
+    // populate constraints:
+    const auto startTimePowers = GetTimePowers(0);
+    const auto endTimePowers = GetTimePowers(K - 1);
+    for (int c = 0; c < S; ++c) {
+      // start waypoint:
+      triplets.emplace_back(
+        currentConstraintIdx, c, Factorials[c][c]/startTimePowers(c)
+      );
+
+      ++currentConstraintIdx;
+
+      // end waypoint:
+      for (int n = c; n < N; ++n) {
+        triplets.emplace_back(
+          currentConstraintIdx, (K - 1)*N + n, Factorials[c][n]/endTimePowers(c)
+        );
+      }
+
+      ++currentConstraintIdx;
+    }
+
+    //
+    // 2. intermediate waypoint passing equality constraints:
+    //
+    for (int k = 1; k < K; ++k) {
+      triplets.emplace_back(
+        currentConstraintIdx, k*N, 1.0
+      );
+      b.row(currentConstraintIdx) = Pos.row(k);
+
+      ++currentConstraintIdx;
+    }
+
+    //
+    // 3. intermediate waypoint continuity constaints:
+    //
+    for (int k = 1; k < K; ++k) {
+      const auto prevTimePowers = GetTimePowers(k - 1);
+      const auto nextTimePowers = GetTimePowers(k);
+
+      for (int c = 0; c < S; ++c) {
+        // constraint index in the layout of the derivative-major loops:
+        const int constraintIdx = currentConstraintIdx + c * (K - 1) + (k - 1);
+
+        // the end of previous trajectory segment:
+        for (int n = c; n < N; ++n) {
+          triplets.emplace_back(
+            constraintIdx,
+            (k - 1) * N + n,
+            Factorials[c][n]/prevTimePowers(c)
+          );
+        }
+
+        // should equal to the start of current trajectory segment:
+        triplets.emplace_back(
+          constraintIdx,
+          k * N + c,
+          -Factorials[c][c]/nextTimePowers(c)
+        );
+      }
+    }
+    currentConstraintIdx += (K - 1) * S;
+
+    return currentConstraintIdx;
+  }
+
+  /**
+   * @brief get the matrix which maps the coeffs of a segment with unit time to the control points of its Bezier curve
+   *
+   * @note s^n in the Bernstein basis of degree N - 1 gives control point i the weight C(i, n) / C(N - 1, n) for n <= i
+   */
+  static const Block &GetBernsteinTransform() {
+    static const Block BernsteinTransform = [] {
+      Block B = Block::Zero();
+      for (int i = 0; i < N; ++i) {
+        for (int n = 0; n <= i; ++n) {
+          B(i, n) = Factorials[n][i] / Factorials[n][N - 1];
+        }
+      }
+      return B;
+    }();
+
+    return BernsteinTransform;
+  }
+
+  /**
+   * @brief split a segment with unit time at tau into two segments with unit time, head on [0, tau] & tail on [tau, 1]
+   */
+  static void Split(const State &coeffs, const double tau, State &head, State &tail) {
+    // head(u) = p(tau*u), tail(u) = p(tau + (1 - tau)*u) expanded with the binomials n!/((n - m)! m!):
+    double headScaling{1.0}, tailScaling{1.0};
+    for (int m = 0; m < N; ++m) {
+      double tailCoeff{0.0}, tauPower{1.0};
+      for (int n = m; n < N; ++n) {
+        tailCoeff += coeffs(n) * Factorials[m][n] / Factorials[m][m] * tauPower;
+        tauPower *= tau;
+      }
+
+      head(m) = headScaling * coeffs(m);
+      tail(m) = tailScaling * tailCoeff;
+
+      headScaling *= tau;
+      tailScaling *= (1.0 - tau);
+    }
+  }
+};
+
+#endif // ASSIGNMENTS_POLY_KERNEL_HPP_
@@ -0,0 +1,170 @@
+#ifndef ASSIGNMENTS_STURM_SEQUENCE_HPP_
+#define ASSIGNMENTS_STURM_SEQUENCE_HPP_
+
+#include <Eigen/Eigen>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief real roots of a polynomial in an interval, isolated by its Sturm sequence & refined by bisection
+ *
+ * @note coeffs are in ascending powers. the num. of sign changes of the sequence drops by one at each distinct root,
+ *       so the count on an interval is exact however close the roots are. remainders which vanish relative to their
+ *       dividend are taken as zero, which ends the sequence at gcd(p, p') for multiple roots
+ */
+class SturmSequence {
+public:
+  /**
+   * @param[in] coeffs polynomial coeffs in ascending powers
+   */
+  explicit SturmSequence(const Eigen::VectorXd &coeffs) {
+    Eigen::VectorXd p = Trim(coeffs);
+    if (p.size() < 2) {
+      // constant, no roots to isolate:
+      return;
+    }
+
+    Eigen::VectorXd q(p.size() - 1);
+    for (int n = 1; n < p.size(); ++n) {
+      q(n - 1) = n * p(n);
+    }
+
+    sequence.push_back(p);
+    sequence.push_back(Trim(q));
+    while (sequence.back().size() > 1) {
+      const Eigen::VectorXd &a = sequence[sequence.size() - 2];
+      const Eigen::VectorXd &b = sequence.back();
+
+      // remainder of a / b by long division from the leading coeff down:
+      Eigen::VectorXd r = a;
+      const int m = a.size() - 1, n = b.size() - 1;
+      for (int i = m - n; i >= 0; --i) {
+        r.segment(i, n + 1) -= (r(i + n) / b(n)) * b;
+      }
+
+      const double scale = a.cwiseAbs().maxCoeff();
+      Eigen::VectorXd next = Trim(-r.head(n), scale);
+      if (next.size() == 0) {
+        break;
+      }
+      sequence.push_back(next);
+    }
+  }
+
+  /**
+   * @brief count the distinct real roots in (lower, upper]
+   */
+  int CountRoots(const double lower, const double upper) const {
+    return CountSignChanges(lower) - CountSignChanges(upper);
+  }
+
+  /**
+   * @brief find the distinct real roots in (lower, upper]
+   *
+   * @param[in] lower lower end of the interval
+   * @param[in] upper upper end of the interval
+   * @param[in] tolerance width of the interval each root is refined to
+   * @param[out] roots the roots in ascending order
+   */
+  void FindRoots(const double lower, const double upper, const double tolerance, std::vector<double> &roots) const {
+    roots.clear();
+    if (sequence.empty()) {
+      return;
+    }
+
+    // intervals with at least one root, the one on top of the stack is the leftmost:
+    std::vector<std::pair<double, double>> intervals{{lower, upper}};
+    while (!intervals.empty()) {
+      double a = intervals.back().first, b = intervals.back().second;
+      intervals.pop_back();
+
+      const int count = CountRoots(a, b);
+      if (count == 0) {
+        continue;
+      }
+
+      if (b - a <= tolerance) {
+        roots.push_back(0.5 * (a + b));
+        continue;
+      }
+
+      // a single simple root, bisect on the sign of the polynomial itself:
+      double pa = Evaluate(sequence.front(), a), pb = Evaluate(sequence.front(), b);
+      if (count == 1 && pa * pb < 0.0) {
+        while (b - a > tolerance) {
+          const double c = 0.5 * (a + b);
+          const double pc = Evaluate(sequence.front(), c);
+          if (pa * pc <= 0.0) {
+            b = c;
+            pb = pc;
+          } else {
+            a = c;
+            pa = pc;
+          }
+        }
+        roots.push_back(0.5 * (a + b));
+        continue;
+      }
+
+      // otherwise split by the sequence:
+      const double c = 0.5 * (a + b);
+      intervals.emplace_back(c, b);
+      intervals.emplace_back(a, c);
+    }
+  }
+
+  /**
+   * @brief evaluate the polynomial with coeffs in ascending powers at x by Horner's rule
+   */
+  static double Evaluate(const Eigen::VectorXd &coeffs, const double x) {
+    double result{0.0};
+    for (int n = coeffs.size() - 1; n >= 0; --n) {
+      result = result * x + coeffs(n);
+    }
+
+    return result;
+  }
+
+private:
+  /**
+   * @brief drop the leading coeffs which vanish relative to scale
+   */
+  static Eigen::VectorXd Trim(const Eigen::VectorXd &coeffs, double scale = 0.0) {
+    if (scale == 0.0 && coeffs.size() > 0) {
+      scale = coeffs.cwiseAbs().maxCoeff();
+    }
+
+    const double threshold = 64.0 * std::numeric_limits<double>::epsilon() * scale;
+    int size = coeffs.size();
+    while (size > 0 && std::abs(coeffs(size - 1)) <= threshold) {
+      --size;
+    }
+
+    return coeffs.head(size);
+  }
+
+  int CountSignChanges(const double x) const {
+    int count{0};
+    double previous{0.0};
+    for (const Eigen::VectorXd &p : sequence) {
+      const double value = Evaluate(p, x);
+      if (value == 0.0) {
+        continue;
+      }
+      if (previous != 0.0 && (value < 0.0) != (previous < 0.0)) {
+        ++count;
+      }
+      previous = value;
+    }
+
+    return count;
+  }
+
+  std::vector<Eigen::VectorXd> sequence;
+};
+
+#endif // ASSIGNMENTS_STURM_SEQUENCE_HPP_
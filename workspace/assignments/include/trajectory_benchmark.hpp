@@ -0,0 +1,346 @@
+#ifndef ASSIGNMENTS_TRAJECTORY_BENCHMARK_HPP_
+#define ASSIGNMENTS_TRAJECTORY_BENCHMARK_HPP_
+
+#include <Eigen/Eigen>
+#include <ros/console.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+//
+// standalone benchmark of a minimum snap generator, numeric & analytic, over num. of segments & continuity orders,
+// shared by the generators of 05 & the capstone:
+//
+//     trajectory_generator_benchmark [output.csv] [num_trials] [max_segments] [seed]
+//
+// each row of the CSV is one solve on random waypoints:
+//
+//     time_ms             wall time of the generator
+//     peak_rss_kb         peak resident set size of the process which ran the case, forked per method, cOrder & K
+//     objective           integral of the squared [tOrder]th derivative, evaluated from the coeffs
+//     waypoint_residual   max. distance from the segment ends to their waypoints
+//     continuity_residual max. jump of the 1st to [cOrder]th derivative at intermediate waypoints, relative to max(1, |value|)
+//     boundary_residual   max. deviation of the start & goal velocity & acceleration from their specifications
+//
+// the waypoints of a trial only depend on the seed, K & the trial index, so every method & cOrder solves the same
+// problems and both benchmarks with the same seed generate the same ones
+//
+namespace trajectory_benchmark {
+// objective order both nodes default to:
+constexpr int TOrder{4};
+// continuity orders the generators support:
+constexpr int COrders[]{2, 3};
+// num. of segments:
+constexpr int NumSegments[]{2, 5, 10, 20, 50, 100, 200, 500, 1000};
+
+// length of the random steps between waypoints:
+constexpr double MinStepLength{1.0};
+constexpr double MaxStepLength{5.0};
+// velocity & acceleration of the trapezoidal time allocation, as in the launch files:
+constexpr double MaxVel{1.0};
+constexpr double MaxAcc{0.5};
+
+enum class Method {
+    Numeric,
+    Analytic
+};
+
+/**
+  * @brief time the polynomial coeffs of a segment are given in, normalized t / T in 05 & real in the capstone
+  */
+enum class CoeffsTime {
+    Normalized,
+    Real
+};
+
+/**
+  * @brief random walk of K steps from the origin, (K + 1)-by-3
+  */
+inline Eigen::MatrixXd GenerateWaypoints(const int K, const unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> direction(0.0, 1.0);
+    std::uniform_real_distribution<double> length(MinStepLength, MaxStepLength);
+
+    Eigen::MatrixXd Pos = Eigen::MatrixXd::Zero(K + 1, 3);
+    for (int k = 0; k < K; ++k) {
+        Eigen::Vector3d step(direction(generator), direction(generator), direction(generator));
+        Pos.row(k + 1) = Pos.row(k) + length(generator) * step.normalized().transpose();
+    }
+
+    return Pos;
+}
+
+/**
+  * @brief time of each segment to accelerate from & stop at its ends under MaxVel & MaxAcc, K-by-1
+  */
+inline Eigen::VectorXd AllocateTimes(const Eigen::MatrixXd &Pos) {
+    const int K = Pos.rows() - 1;
+    // distance to reach MaxVel & stop again:
+    const double rampDistance = MaxVel * MaxVel / MaxAcc;
+
+    Eigen::VectorXd Time(K);
+    for (int k = 0; k < K; ++k) {
+        const double distance = (Pos.row(k + 1) - Pos.row(k)).norm();
+        Time(k) = (
+            distance > rampDistance ?
+            distance / MaxVel + MaxVel / MaxAcc :
+            2.0 * std::sqrt(distance / MaxAcc)
+        );
+    }
+
+    return Time;
+}
+
+/**
+  * @brief partial factorial n!/(n - d)!, the factor of x^(n - d) in the [d]th derivative of x^n
+  */
+inline double GetFactorial(const int n, const int d) {
+    double result{1.0};
+    for (int i = n - d + 1; i <= n; ++i) {
+        result *= i;
+    }
+
+    return result;
+}
+
+/**
+  * @brief evaluate the [d]th derivative in real time of a segment of duration T with ascending coeffs at t in [0, T]
+  */
+inline double EvaluateDerivative(
+    const Eigen::VectorXd &coeffs,
+    const CoeffsTime coeffsTime,
+    const double T,
+    const int d,
+    const double t
+) {
+    // d/dt = d/ds / T in normalized time s = t / T:
+    const double x = (coeffsTime == CoeffsTime::Normalized ? t / T : t);
+
+    double result{0.0};
+    for (int n = coeffs.size() - 1; n >= d; --n) {
+        result = result * x + GetFactorial(n, d) * coeffs(n);
+    }
+
+    return (coeffsTime == CoeffsTime::Normalized ? result * std::pow(T, -d) : result);
+}
+
+struct Residuals {
+    double objective{0.0};
+    double waypoint{0.0};
+    double continuity{0.0};
+    double boundary{0.0};
+};
+
+/**
+  * @brief evaluate the objective & constraint residuals of coeffs in [coeffsTime], K-by-(3 * N)
+  */
+inline Residuals EvaluateResiduals(
+    const int cOrder,
+    const Eigen::MatrixXd &coeffs,
+    const CoeffsTime coeffsTime,
+    const Eigen::MatrixXd &Pos,
+    const Eigen::MatrixXd &Vel,
+    const Eigen::MatrixXd &Acc,
+    const Eigen::VectorXd &Time
+) {
+    const int N = coeffs.cols() / 3;
+    const int K = Time.size();
+
+    Residuals residuals;
+    for (int dim = 0; dim < Pos.cols(); ++dim) {
+        for (int k = 0; k < K; ++k) {
+            const Eigen::VectorXd segment = coeffs.block(k, dim * N, 1, N).transpose();
+            const double T = Time(k);
+
+            // objective, over s in [0, 1] & scaled by T^(1 - 2*tOrder) in normalized time, over t in [0, T] in real time:
+            const double upper = (coeffsTime == CoeffsTime::Normalized ? 1.0 : T);
+
+            double objective{0.0};
+            for (int m = TOrder; m < N; ++m) {
+                for (int n = TOrder; n < N; ++n) {
+                    const int exponent = m + n - 2 * TOrder + 1;
+                    objective += (
+                        segment(m) * segment(n) *
+                        GetFactorial(m, TOrder) *
+                        GetFactorial(n, TOrder) *
+                        std::pow(upper, exponent) / exponent
+                    );
+                }
+            }
+            residuals.objective += (coeffsTime == CoeffsTime::Normalized ? objective * std::pow(T, 1 - 2 * TOrder) : objective);
+
+            // waypoint passing:
+            residuals.waypoint = std::max({
+                residuals.waypoint,
+                std::abs(EvaluateDerivative(segment, coeffsTime, T, 0, 0.0) - Pos(k, dim)),
+                std::abs(EvaluateDerivative(segment, coeffsTime, T, 0, T) - Pos(k + 1, dim))
+            });
+
+            // continuity with the next segment:
+            if (k + 1 < K) {
+                const Eigen::VectorXd next = coeffs.block(k + 1, dim * N, 1, N).transpose();
+                for (int d = 1; d <= cOrder; ++d) {
+                    const double end = EvaluateDerivative(segment, coeffsTime, T, d, T);
+                    const double start = EvaluateDerivative(next, coeffsTime, Time(k + 1), d, 0.0);
+                    residuals.continuity = std::max(
+                        residuals.continuity,
+                        std::abs(end - start) / std::max({1.0, std::abs(end), std::abs(start)})
+                    );
+                }
+            }
+        }
+
+        // boundary velocity & acceleration:
+        const Eigen::VectorXd first = coeffs.block(0, dim * N, 1, N).transpose();
+        const Eigen::VectorXd last = coeffs.block(K - 1, dim * N, 1, N).transpose();
+        const double TFirst = Time(0), TLast = Time(K - 1);
+        residuals.boundary = std::max({
+            residuals.boundary,
+            std::abs(EvaluateDerivative(first, coeffsTime, TFirst, 1, 0.0) - Vel(0, dim)),
+            std::abs(EvaluateDerivative(last, coeffsTime, TLast, 1, TLast) - Vel(1, dim)),
+            std::abs(EvaluateDerivative(first, coeffsTime, TFirst, 2, 0.0) - Acc(0, dim)),
+            std::abs(EvaluateDerivative(last, coeffsTime, TLast, 2, TLast) - Acc(1, dim))
+        });
+    }
+
+    return residuals;
+}
+
+/**
+  * @brief run the trials of one case & append their rows to the CSV, in the forked process of the case
+  */
+template <typename Generate>
+void RunCase(
+    const std::string &filename,
+    const std::string &generator,
+    const CoeffsTime coeffsTime,
+    Generate &generate,
+    const Method method,
+    const int cOrder,
+    const int K,
+    const int numTrials,
+    const unsigned int seed
+) {
+    std::ofstream output(filename, std::ios::app);
+    output.precision(9);
+
+    const Eigen::MatrixXd Vel = Eigen::MatrixXd::Zero(2, 3);
+    const Eigen::MatrixXd Acc = Eigen::MatrixXd::Zero(2, 3);
+
+    // warm up the static tables & the allocator with an untimed solve of the first trial:
+    {
+        const Eigen::MatrixXd Pos = GenerateWaypoints(K, seed + 7919u * K);
+        generate(method, TOrder, cOrder, Pos, Vel, Acc, AllocateTimes(Pos));
+    }
+
+    for (int trial = 0; trial < numTrials; ++trial) {
+        const Eigen::MatrixXd Pos = GenerateWaypoints(K, seed + 7919u * K + trial);
+        const Eigen::VectorXd Time = AllocateTimes(Pos);
+
+        // tic:
+        const auto tStart = std::chrono::steady_clock::now();
+
+        const Eigen::MatrixXd coeffs = generate(method, TOrder, cOrder, Pos, Vel, Acc, Time);
+
+        // toc:
+        const auto tEnd = std::chrono::steady_clock::now();
+        const std::chrono::duration<double, std::milli> durationMs = tEnd - tStart;
+
+        // ru_maxrss is in kilobytes on Linux:
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        const Residuals residuals = EvaluateResiduals(cOrder, coeffs, coeffsTime, Pos, Vel, Acc, Time);
+
+        output << generator << ","
+               << (method == Method::Numeric ? "numeric" : "analytic") << ","
+               << cOrder << ","
+               << TOrder << ","
+               << K << ","
+               << trial << ","
+               << durationMs.count() << ","
+               << usage.ru_maxrss << ","
+               << residuals.objective << ","
+               << residuals.waypoint << ","
+               << residuals.continuity << ","
+               << residuals.boundary << "\n";
+    }
+}
+
+/**
+  * @brief run the benchmark on the command line arguments
+  *
+  * @param[in] generator name of the generator in the CSV
+  * @param[in] coeffsTime time the coeffs of the generator are given in
+  * @param[in] generate callable (method, tOrder, cOrder, Pos, Vel, Acc, Time) -> coeffs, K-by-(3 * N)
+  *
+  * @return exit status of the process
+  */
+template <typename Generate>
+int Run(int argc, char** argv, const std::string &generator, const CoeffsTime coeffsTime, Generate generate) {
+    const std::string filename = (argc > 1 ? argv[1] : "trajectory_generator_benchmark.csv");
+    const int numTrials = (argc > 2 ? std::atoi(argv[2]) : 5);
+    const int maxSegments = (argc > 3 ? std::atoi(argv[3]) : 1000);
+    const unsigned int seed = (argc > 4 ? static_cast<unsigned int>(std::atoi(argv[4])) : 0u);
+
+    // the generators report every solve through ROS_WARN, only keep their errors:
+    if (ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Error)) {
+        ros::console::notifyLoggerLevelsChanged();
+    }
+
+    {
+        std::ofstream output(filename, std::ios::trunc);
+        if (!output) {
+            std::cerr << "[Benchmark]: Failed to open " << filename << std::endl;
+            return EXIT_FAILURE;
+        }
+        output << "generator,method,c_order,t_order,num_segments,trial,time_ms,peak_rss_kb,"
+               << "objective,waypoint_residual,continuity_residual,boundary_residual\n";
+    }
+
+    for (const Method method : {Method::Numeric, Method::Analytic}) {
+        for (const int cOrder : COrders) {
+            for (const int K : NumSegments) {
+                if (K > maxSegments) {
+                    continue;
+                }
+
+                std::cerr << "[Benchmark]: "
+                          << (method == Method::Numeric ? "numeric" : "analytic")
+                          << ", cOrder " << cOrder << ", K " << K << std::endl;
+
+                // each case runs in its own process, so its peak memory is not the one of a previous case:
+                const pid_t pid = fork();
+                if (pid < 0) {
+                    std::cerr << "[Benchmark]: Failed to fork." << std::endl;
+                    return EXIT_FAILURE;
+                }
+                if (pid == 0) {
+                    RunCase(filename, generator, coeffsTime, generate, method, cOrder, K, numTrials, seed);
+                    _exit(EXIT_SUCCESS);
+                }
+
+                int status{0};
+                waitpid(pid, &status, 0);
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+                    std::cerr << "[Benchmark]: Case failed with status " << status << std::endl;
+                }
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+}
+
+#endif // ASSIGNMENTS_TRAJECTORY_BENCHMARK_HPP_
@@ -0,0 +1,152 @@
+#ifndef ASSIGNMENTS_TRAJECTORY_FEASIBILITY_HPP_
+#define ASSIGNMENTS_TRAJECTORY_FEASIBILITY_HPP_
+
+#include "sturm_sequence.hpp"
+
+#include <Eigen/Eigen>
+#include <ros/console.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief velocity & acceleration limits of the piecewise polynomial trajectories of 05 & the capstone
+ *
+ * @note the generators store their coeffs in normalized & in real time respectively, so each of them converts the
+ *       [d]th derivative of a segment to normalized time and passes it here, everything else is shared
+ */
+namespace trajectory_feasibility {
+// width in normalized time each extremum of the velocity & acceleration norms is refined to:
+constexpr double RootTolerance{1e-9};
+// extra stretch of violating segments, as the regenerated neighbours pull them back towards the limits:
+constexpr double StretchMargin{0.05};
+
+/**
+  * @brief get the max. norm over s in [0, 1] of a 3D polynomial
+  *
+  * @param[in] coeffs polynomial coeffs in ascending powers of the normalized time s, M-by-3
+  *
+  * @return max. of the norm, at an end or at a root of the derivative of the squared norm
+  * @note the roots are isolated by Sturm sequence, so no extremum between samples is missed
+  */
+inline double GetMaxNorm(const Eigen::MatrixXd &coeffs) {
+    const int M = coeffs.rows();
+    if (M == 0) {
+        return 0.0;
+    }
+
+    // 1. squared norm, of degree 2 * (M - 1):
+    Eigen::VectorXd squaredNorm = Eigen::VectorXd::Zero(2 * M - 1);
+    for (int dim = 0; dim < coeffs.cols(); ++dim) {
+        for (int i = 0; i < M; ++i) {
+            squaredNorm.segment(i, M) += coeffs(i, dim) * coeffs.col(dim);
+        }
+    }
+
+    // 2. the max. is at an end or at a root of its derivative in between:
+    Eigen::VectorXd slope = Eigen::VectorXd::Zero(std::max(2 * M - 2, 1));
+    for (int n = 1; n < 2 * M - 1; ++n) {
+        slope(n - 1) = n * squaredNorm(n);
+    }
+
+    std::vector<double> roots;
+    SturmSequence(slope).FindRoots(0.0, 1.0, RootTolerance, roots);
+
+    double maxSquaredNorm = std::max(SturmSequence::Evaluate(squaredNorm, 0.0), SturmSequence::Evaluate(squaredNorm, 1.0));
+    for (const double s : roots) {
+        maxSquaredNorm = std::max(maxSquaredNorm, SturmSequence::Evaluate(squaredNorm, s));
+    }
+
+    return std::sqrt(std::max(maxSquaredNorm, 0.0));
+}
+
+/**
+  * @brief get the factors which stretch the segments violating the velocity or acceleration limit
+  *
+  * @param[in] K num. of trajectory segments
+  * @param[in] velLimit max. velocity
+  * @param[in] accLimit max. acceleration
+  * @param[in] getMaxDerivativeNorm callable (k, d) -> max. norm of the [d]th derivative of segment k in real time
+  *
+  * @return stretch of each segment, 1.0 if it is feasible. stretching a segment by r scales its velocity by 1/r and
+  *         its acceleration by 1/r^2, so the factor is the larger of the velocity & the square root of the acceleration
+  *         ratio, plus a small margin
+  */
+template <typename GetMaxDerivativeNorm>
+Eigen::VectorXd GetTimeStretches(
+    const int K,
+    const double velLimit,
+    const double accLimit,
+    GetMaxDerivativeNorm getMaxDerivativeNorm
+) {
+    Eigen::VectorXd stretches = Eigen::VectorXd::Ones(K);
+    for (int k = 0; k < K; ++k) {
+        const double maxVel = getMaxDerivativeNorm(k, 1);
+        const double maxAcc = getMaxDerivativeNorm(k, 2);
+
+        const double ratio = std::max(maxVel / velLimit, std::sqrt(maxAcc / accLimit));
+        if (ratio > 1.0) {
+            stretches(k) = (1.0 + StretchMargin) * ratio;
+        }
+    }
+
+    return stretches;
+}
+
+/**
+  * @brief stretch the segments whose max. velocity or acceleration exceeds the limits and regenerate, until the
+  *        trajectory is feasible or [maxIterations] regenerations are spent
+  *
+  * @param[in,out] time allocated time for each trajectory segment, K-by-1
+  * @param[in] maxIterations max. num. of regenerations
+  * @param[in] getTimeStretches callable () -> stretches of the current trajectory, as GetTimeStretches
+  * @param[in] regenerate callable () which regenerates the trajectory for [time]
+  *
+  * @return true if the final trajectory is within the limits. it is checked once more after the last regeneration
+  *         and a violation left is reported
+  */
+template <typename GetTimeStretches, typename Regenerate>
+bool StretchToLimits(
+    Eigen::VectorXd &time,
+    const int maxIterations,
+    GetTimeStretches getTimeStretches,
+    Regenerate regenerate
+) {
+    double prevMaxStretch = std::numeric_limits<double>::infinity();
+    for (int i = 0; ; ++i) {
+        Eigen::VectorXd stretches = getTimeStretches();
+
+        const int numViolations = (stretches.array() > 1.0).count();
+        if (numViolations == 0) {
+            return true;
+        }
+
+        const double maxStretch = stretches.maxCoeff();
+        if (i >= maxIterations) {
+            ROS_WARN(
+                "[Feasibility]: %d of %d segments still exceed the limits after %d iterations, max. stretch %.2f",
+                numViolations, static_cast<int>(stretches.size()), i, maxStretch
+            );
+            return false;
+        }
+
+        ROS_WARN(
+            "[Feasibility]: %d of %d segments exceed the limits, max. stretch %.2f",
+            numViolations, static_cast<int>(stretches.size()), maxStretch
+        );
+
+        // a long segment between fast waypoints may overshoot more, then slow the whole trajectory down instead:
+        if (maxStretch >= prevMaxStretch) {
+            stretches.setConstant(maxStretch);
+        }
+        prevMaxStretch = maxStretch;
+
+        time = time.cwiseProduct(stretches);
+        regenerate();
+    }
+}
+}
+
+#endif // ASSIGNMENTS_TRAJECTORY_FEASIBILITY_HPP_